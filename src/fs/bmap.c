@@ -3,88 +3,116 @@
 #include "../include/conix/buffer.h"
 #include "../include/conix/fs.h"
 
-idx_t balloc(dev_t dev) {
+//  i ߼λͼ ZMAP_NR Ĳʱȡ
+static buffer_t *zmap_get(super_block_t *sb, uint32 i) {
+  if (i < ZMAP_NR) {
+    assert(sb->zmap[i]);
+    return sb->zmap[i];
+  }
+  return bread(sb->dev, 2 + sb->imap_blocks + i);
+}
+
+static void zmap_put(super_block_t *sb, buffer_t *buf, uint32 i) {
+  if (i < ZMAP_NR) {
+    bwrite(buf);
+  } else {
+    brelse(buf);
+  }
+}
+
+idx_t balloc_near(dev_t dev, idx_t goal) {
   super_block_t *sb = get_super(dev);
   assert(sb);
+  write_lock(&sb->lock);
+
+  if (goal < sb->firstdatazone || goal >= sb->zones) {
+    goal = sb->firstdatazone;
+  }
 
-  buffer_t *buf = NULL;
   idx_t bit = EOF;
   bitmap_t map;
+  uint32 first = (goal - sb->firstdatazone + 1) / BLOCK_BITS;
 
-  for (size_t i = 0; i < ZMAP_NR; ++i) {
-    buf = sb->zmap[i];
-    assert(buf);
+  //  goal ڵλͼ鿪ʼƻصͷ
+  for (size_t n = 0; n < sb->zmap_blocks; ++n) {
+    uint32 i = (first + n) % sb->zmap_blocks;
+    buffer_t *buf = zmap_get(sb, i);
 
     // bufferΪλͼ
     bitmap_make(&map, buf->data, BLOCK_SIZE,
-                i * BLOCK_BITS + sb->desc->firstdatazone - 1);
+                i * BLOCK_BITS + sb->firstdatazone - 1);
 
-    bit = bitmap_scan(&map, 1);
+    bit = bitmap_alloc(&map, n ? map.offset : goal);
+    if (bit == EOF && !n) {
+      bit = bitmap_alloc(&map, map.offset);
+    }
     if (bit != EOF) {
-      assert(bit < sb->desc->zones);
+      assert(bit < sb->zones);
       buf->dirty = true;
+    }
+    zmap_put(sb, buf, i);
+    if (bit != EOF) {
       break;
     }
   }
-  bwrite(buf);
+  write_unlock(&sb->lock);
   return bit;
 }
 
+idx_t balloc(dev_t dev) { return balloc_near(dev, 0); }
+
 void bfree(dev_t dev, idx_t idx) {
   super_block_t *sb = get_super(dev);
   assert(sb != NULL);
-  assert(idx < sb->desc->zones);
+  assert(idx >= sb->firstdatazone && idx < sb->zones);
+  write_lock(&sb->lock);
 
-  buffer_t *buf;
-  bitmap_t map;
-  for (size_t i = 0; i < ZMAP_NR; ++i) {
-    if (idx > BLOCK_BITS * (i + 1)) {
-      continue;
-    }
-
-    buf = sb->zmap[i];
-    assert(buf);
-
-    bitmap_make(&map, buf->data, BLOCK_SIZE,
-                BLOCK_BITS * i + sb->desc->firstdatazone - 1);
-    // 0
-    assert(bitmap_test(&map, idx));
-    bitmap_set(&map, idx, 0);
+  uint32 i = (idx - sb->firstdatazone + 1) / BLOCK_BITS;
+  buffer_t *buf = zmap_get(sb, i);
 
-    buf->dirty = true;
-    break;
-  }
-  bwrite(buf);
+  bitmap_t map;
+  bitmap_make(&map, buf->data, BLOCK_SIZE,
+              BLOCK_BITS * i + sb->firstdatazone - 1);
+  // 0
+  assert(bitmap_test(&map, idx));
+  bitmap_set(&map, idx, 0);
+
+  buf->dirty = true;
+  zmap_put(sb, buf, i);
+  write_unlock(&sb->lock);
 }
 
 idx_t ialloc(dev_t dev) {
   super_block_t *sb = get_super(dev);
   assert(sb);
+  write_lock(&sb->lock);
 
   buffer_t *buf = NULL;
   idx_t bit = EOF;
   bitmap_t map;
 
-  for (size_t i = 0; i < IMAP_NR; ++i) {
+  for (size_t i = 0; i < sb->imap_blocks; ++i) {
     buf = sb->imap[i];
     assert(buf);
 
     bitmap_make(&map, buf->data, BLOCK_BITS, i * BLOCK_BITS);
     bit = bitmap_scan(&map, 1);
     if (bit != EOF) {
-      assert(bit < sb->desc->inodes);
+      assert(bit < sb->inodes);
       buf->dirty = true;
       break;
     }
   }
   bwrite(buf);
+  write_unlock(&sb->lock);
   return bit;
 }
 
 void ifree(dev_t dev, idx_t idx) {
   super_block_t *sb = get_super(dev);
   assert(sb);
-  assert(idx < sb->desc->inodes);
+  assert(idx < sb->inodes);
+  write_lock(&sb->lock);
 
   buffer_t *buf;
   bitmap_t map;
@@ -104,9 +132,11 @@ void ifree(dev_t dev, idx_t idx) {
     break;
   }
   bwrite(buf);
+  write_unlock(&sb->lock);
 }
 
-idx_t bmap(inode_t *inode, idx_t block, bool create) {
+// 𼶲ҵ stop Ϊֹ0 Ϊļ鱾
+static idx_t bmap_level(inode_t *inode, idx_t block, bool create, int stop) {
   assert(block >= 0 && block < TOTAL_BLOCK);
 
   uint16 index = block;
@@ -138,13 +168,16 @@ idx_t bmap(inode_t *inode, idx_t block, bool create) {
 reckon:
   for (; level >= 0; level--) {
     if (!array[index] && create) {
-      array[index] = balloc(inode->dev);
-      buf->dirty = true;
+      idx_t nr = balloc(inode->dev);
+      if (nr != EOF) {
+        array[index] = nr;
+        buf->dirty = true;
+      }
     }
 
     brelse(buf);
 
-    if (level == 0 || !array[index]) {
+    if (level == stop || !array[index]) {
       return array[index];
     }
 
@@ -155,3 +188,58 @@ reckon:
     array = (uint16 *)buf->data;
   }
 }
+
+// ߳ inode 
+idx_t bmap(inode_t *inode, idx_t block, bool create) {
+  if (inode->extent) {
+    return extent_bmap(inode, block, create);
+  }
+  return bmap_level(inode, block, create, 0);
+}
+
+void bmap_range(inode_t *inode, idx_t block, uint32 count, idx_t *nrs,
+                bool create) {
+  if (inode->extent) {
+    for (size_t i = 0; i < count; ++i) {
+      nrs[i] = extent_bmap(inode, block + i, create);
+    }
+    return;
+  }
+  assert(block + count <= TOTAL_BLOCK);
+
+  buffer_t *leaf = NULL; // һӿ
+  idx_t first = 0;       // leaf һӦļ
+
+  for (size_t i = 0; i < count; ++i, ++block) {
+    if (block < DIRECT_BLOCK) {
+      nrs[i] = bmap(inode, block, create);
+      continue;
+    }
+
+    // һͶӿÿҶӶ BLOCK_INDEXES ļ
+    uint32 index = (block - DIRECT_BLOCK) % BLOCK_INDEXES;
+    if (!leaf || block - first >= BLOCK_INDEXES) {
+      brelse(leaf);
+      leaf = NULL;
+      first = block - index;
+
+      idx_t nr = bmap_level(inode, block, create, 1);
+      if (!nr) {
+        nrs[i] = 0;
+        continue;
+      }
+      leaf = bread(inode->dev, nr);
+    }
+
+    uint16 *array = (uint16 *)leaf->data;
+    if (!array[index] && create) {
+      idx_t nr = balloc(inode->dev);
+      if (nr != EOF) {
+        array[index] = nr;
+        leaf->dirty = true;
+      }
+    }
+    nrs[i] = array[index];
+  }
+  brelse(leaf);
+}
@@ -0,0 +1,106 @@
+#include "../include/conix/assert.h"
+#include "../include/conix/buffer.h"
+#include "../include/conix/fs.h"
+
+// ֲһʼļ鲻 block 䣬ûʱ -1
+static int extent_search(extent_t *extents, int count, idx_t block) {
+  int low = 0;
+  int high = count - 1;
+  int idx = -1;
+  while (low <= high) {
+    int mid = (low + high) / 2;
+    if (extents[mid].block <= block) {
+      idx = mid;
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return idx;
+}
+
+// ߳ inode ߴʱ 0
+idx_t extent_bmap(inode_t *inode, idx_t block, bool create) {
+  extent_inode_desc_t *desc = (extent_inode_desc_t *)inode->desc;
+  if (!desc->eblock) {
+    if (!create) {
+      return 0;
+    }
+    idx_t eblock = balloc(inode->dev);
+    if (eblock == EOF) {
+      return 0;
+    }
+    desc->eblock = eblock;
+    desc->extents = 0;
+    inode->buf->dirty = true;
+  }
+
+  buffer_t *buf = bread(inode->dev, desc->eblock);
+  extent_t *extents = (extent_t *)buf->data;
+
+  int idx = extent_search(extents, desc->extents, block);
+  if (idx >= 0 && block < extents[idx].block + extents[idx].count) {
+    idx_t nr = extents[idx].start + block - extents[idx].block;
+    brelse(buf);
+    return nr;
+  }
+  if (!create) {
+    brelse(buf);
+    return 0;
+  }
+
+  // ǰһ䣬ʱֱӳ
+  extent_t *prev = idx >= 0 ? &extents[idx] : NULL;
+  idx_t goal = prev ? prev->start + block - prev->block : 0;
+  idx_t nr = balloc_near(inode->dev, goal);
+  if (nr == EOF) {
+    brelse(buf);
+    return 0;
+  }
+
+  if (prev && prev->block + prev->count == block &&
+      prev->start + prev->count == nr) {
+    prev->count++;
+  } else {
+    // ûпλļ
+    if (desc->extents == EXTENT_MAX) {
+      bfree(inode->dev, nr);
+      brelse(buf);
+      return 0;
+    }
+    extent_t *ext = &extents[idx + 1];
+    for (int i = desc->extents; i > idx + 1; --i) {
+      extents[i] = extents[i - 1];
+    }
+    ext->block = block;
+    ext->start = nr;
+    ext->count = 1;
+    desc->extents++;
+    inode->buf->dirty = true;
+  }
+
+  buf->dirty = true;
+  brelse(buf);
+  return nr;
+}
+
+void extent_truncate(inode_t *inode) {
+  extent_inode_desc_t *desc = (extent_inode_desc_t *)inode->desc;
+  if (!desc->eblock) {
+    return;
+  }
+
+  buffer_t *buf = bread(inode->dev, desc->eblock);
+  extent_t *extents = (extent_t *)buf->data;
+  for (size_t i = 0; i < desc->extents; ++i) {
+    for (size_t j = 0; j < extents[i].count; ++j) {
+      bfree(inode->dev, extents[i].start + j);
+    }
+  }
+  brelse(buf);
+  bfree(inode->dev, desc->eblock);
+
+  desc->eblock = 0;
+  desc->extents = 0;
+  inode->buf->dirty = true;
+}
@@ -1,47 +1,41 @@
+#include "../include/conix/arena.h"
 #include "../include/conix/assert.h"
 #include "../include/conix/device.h"
 #include "../include/conix/fs.h"
 #include "../include/conix/task.h"
 
-#define FILE_NR 128
-
-file_t file_table[FILE_NR];
-
+// file_t  kmalloc ڴ䣬
 file_t *get_file() {
-  for (size_t i = 3; i < FILE_NR; ++i) {
-    file_t *file = &file_table[i];
-    if (!file->count) {
-      file->count++;
-      return file;
-    }
-  }
-
-  panic("Exceed max open files");
+  file_t *file = kmalloc(sizeof(file_t));
+  file->count = 1;
+  return file;
 }
 
-void *put_file(file_t *file) {
+void put_file(file_t *file) {
   assert(file->count > 0);
   file->count--;
   if (file->count == 0) {
     iput(file->inode);
+    kfree(file);
   }
 }
 
-fd_t sys_open(char *filename, int flags, int mode) {
+fd_t file_open(task_t *task, char *filename, int flags, int mode) {
   inode_t *inode = inode_open(filename, flags, mode);
   if (!inode) {
     return EOF;
   }
 
-  task_t *task = running_task();
-  fd_t fd = task_get_fd(task);
   file_t *file = get_file();
-  assert(task->files[fd] == NULL);
-  task->files[fd] = file;
+  fd_t fd = task_get_fd(task, file);
+  if (fd == EOF) {
+    kfree(file);
+    iput(inode);
+    return EOF;
+  }
 
   file->inode = inode;
   file->flags = flags;
-  file->count = 1;
   file->mode = inode->desc->mode;
   file->offset = 0;
 
@@ -51,15 +45,16 @@ fd_t sys_open(char *filename, int flags, int mode) {
   return fd;
 }
 
+fd_t sys_open(char *filename, int flags, int mode) {
+  return file_open(running_task(), filename, flags, mode);
+}
+
 fd_t sys_creat(char *filename, int mode) {
   return sys_open(filename, O_CREAT | O_TRUNC, mode);
 }
 
-void sys_close(fd_t fd) {
-  assert(fd < TASK_FILE_NR);
-
-  task_t *task = running_task();
-  file_t *file = task->files[fd];
+void file_close(task_t *task, fd_t fd) {
+  file_t *file = task_file(task, fd);
   if (!file) {
     return;
   }
@@ -68,6 +63,8 @@ void sys_close(fd_t fd) {
   task_put_fd(task, fd);
 }
 
+void sys_close(fd_t fd) { file_close(running_task(), fd); }
+
 int32 sys_read(fd_t fd, char *buf, int count) {
   if (fd == stdin) {
     device_t *device = device_find(DEV_KEYBOARD, 0);
@@ -75,8 +72,8 @@ int32 sys_read(fd_t fd, char *buf, int count) {
   }
 
   task_t *task = running_task();
-  file_t *file = task->files[fd];
-  if ((file->flags & O_ACCMODE) == O_WRONLY) {
+  file_t *file = task_file(task, fd);
+  if (!file || (file->flags & O_ACCMODE) == O_WRONLY) {
     return EOF;
   }
 
@@ -95,9 +92,9 @@ int32 sys_write(fd_t fd, char *buf, int count) {
   }
 
   task_t *task = running_task();
-  file_t *file = task->files[fd];
+  file_t *file = task_file(task, fd);
 
-  if ((file->flags & O_ACCMODE) == O_RDONLY) {
+  if (!file || (file->flags & O_ACCMODE) == O_RDONLY) {
     return EOF;
   }
 
@@ -110,9 +107,131 @@ int32 sys_write(fd_t fd, char *buf, int count) {
   return len;
 }
 
+int32 sys_readv(fd_t fd, iovec_t *iov, int count) {
+  if (count <= 0 || count > IOV_MAX) {
+    return EOF;
+  }
+
+  // 豸ûļƫƣζд
+  if (fd == stdin) {
+    int32 total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      int32 len = sys_read(fd, iov[i].base, iov[i].len);
+      if (len == EOF) {
+        return total ? total : EOF;
+      }
+      total += len;
+    }
+    return total;
+  }
+
+  task_t *task = running_task();
+  file_t *file = task_file(task, fd);
+  if (!file || (file->flags & O_ACCMODE) == O_WRONLY) {
+    return EOF;
+  }
+
+  int len = inode_readv(file->inode, iov, count, file->offset);
+  if (len != EOF) {
+    file->offset += len;
+  }
+  return len;
+}
+
+int32 sys_writev(fd_t fd, iovec_t *iov, int count) {
+  if (count <= 0 || count > IOV_MAX) {
+    return EOF;
+  }
+
+  if (fd == stdout || fd == stderr) {
+    int32 total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      int32 len = sys_write(fd, iov[i].base, iov[i].len);
+      if (len == EOF) {
+        return total ? total : EOF;
+      }
+      total += len;
+    }
+    return total;
+  }
+
+  task_t *task = running_task();
+  file_t *file = task_file(task, fd);
+  if (!file || (file->flags & O_ACCMODE) == O_RDONLY) {
+    return EOF;
+  }
+
+  int len = inode_writev(file->inode, iov, count, file->offset);
+  if (len != EOF) {
+    file->offset += len;
+  }
+  return len;
+}
+
+// ָλöдʹҲıļƫ
+int32 sys_pread(fd_t fd, char *buf, int count, off_t offset) {
+  if (fd <= stderr || offset < 0) {
+    return EOF;
+  }
+
+  task_t *task = running_task();
+  file_t *file = task_file(task, fd);
+  if (!file || (file->flags & O_ACCMODE) == O_WRONLY) {
+    return EOF;
+  }
+  return inode_read(file->inode, buf, count, offset);
+}
+
+int32 sys_pwrite(fd_t fd, char *buf, int count, off_t offset) {
+  if (fd <= stderr || offset < 0) {
+    return EOF;
+  }
+
+  task_t *task = running_task();
+  file_t *file = task_file(task, fd);
+  if (!file || (file->flags & O_ACCMODE) == O_RDONLY) {
+    return EOF;
+  }
+  return inode_write(file->inode, buf, count, offset);
+}
+
+// ںо帴ļoffset Ϊʱʹòƽ in ļƫƣ
+//  *offset ȡ
+int32 sys_sendfile(fd_t out, fd_t in, off_t *offset, int count) {
+  if (out <= stderr || in <= stderr || count < 0) {
+    return EOF;
+  }
+
+  task_t *task = running_task();
+  file_t *infile = task_file(task, in);
+  file_t *outfile = task_file(task, out);
+  if (!infile || !outfile || (infile->flags & O_ACCMODE) == O_WRONLY ||
+      (outfile->flags & O_ACCMODE) == O_RDONLY) {
+    return EOF;
+  }
+
+  off_t pos = offset ? *offset : infile->offset;
+  int len = inode_copy(outfile->inode, outfile->offset, infile->inode, pos,
+                       count);
+  if (len == EOF) {
+    return EOF;
+  }
+
+  outfile->offset += len;
+  if (offset) {
+    *offset = pos + len;
+  } else {
+    infile->offset += len;
+  }
+  return len;
+}
+
 int sys_lseek(fd_t fd, off_t offset, whence_t whence) {
   task_t *task = running_task();
-  file_t *file = task->files[fd];
+  file_t *file = task_file(task, fd);
+  if (!file) {
+    return EOF;
+  }
 
   switch (whence) {
   case SEEK_SET:
@@ -130,14 +249,3 @@ int sys_lseek(fd_t fd, off_t offset, whence_t whence) {
   }
   return file->offset;
 }
-
-void file_init() {
-  for (size_t i = 3; i < FILE_NR; ++i) {
-    file_t *file = &file_table[i];
-    file->inode = NULL;
-    file->count = 0;
-    file->mode = 0;
-    file->flags = 0;
-    file->offset = 0;
-  }
-}
\ No newline at end of file
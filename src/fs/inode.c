@@ -7,43 +7,29 @@
 #include "../include/conix/string.h"
 #include "../include/conix/syscall.h"
 
-#define INODE_NR 64
+#define INODE_HASH_COUNT 61 // inode ϣͰ
+#define INODE_LRU_MAX 128    // ໺δ inode
+#define COPY_BATCH 16        // ʱһӳļ
 
-static inode_t inode_table[INODE_NR];
+static list_t hash_table[INODE_HASH_COUNT]; //  (dev, nr) ɢе inode
+static list_t lru_list; // δõ inodeͷŵͷ
+static uint32 lru_count;
 
-static inode_t *get_free_inode() {
-  for (size_t i = 0; i < INODE_NR; ++i) {
-    inode_t *inode = &inode_table[i];
-    if (inode->dev == EOF) {
-      return inode;
-    }
-  }
-
-  panic("no more inode");
+static list_t *inode_hash(dev_t dev, idx_t nr) {
+  return &hash_table[(dev ^ nr) % INODE_HASH_COUNT];
 }
 
-static void put_free_inode(inode_t *inode) {
-  assert(inode != inode_table);
-  assert(inode->count == 0);
-  inode->dev = EOF;
-}
-
-inode_t *get_root_inode() { return inode_table; }
-
 // inode nrӦĿ
 static idx_t inode_block(super_block_t *sb, idx_t nr) {
-  return 2 + sb->desc->imap_blocks + sb->desc->zmap_blocks +
-         (nr - 1) / BLOCK_INODES;
+  return 2 + sb->imap_blocks + sb->zmap_blocks + (nr - 1) / BLOCK_INODES;
 }
 
 static inode_t *find_inode(dev_t dev, idx_t nr) {
-  super_block_t *sb = get_super(dev);
-  assert(sb);
-  list_t *list = &sb->inode_list;
+  list_t *list = inode_hash(dev, nr);
   for (list_node_t *node = list->head.next; node != &list->tail;
        node = node->next) {
     inode_t *inode = element_entry(inode_t, node, node);
-    if (inode->nr == nr) {
+    if (inode->dev == dev && inode->nr == nr) {
       return inode;
     }
   }
@@ -51,9 +37,21 @@ static inode_t *find_inode(dev_t dev, idx_t nr) {
   return NULL;
 }
 
+// ӻгɾ
+static void put_free_inode(inode_t *inode) {
+  assert(inode->count == 0);
+  brelse(inode->buf);
+  list_remove(&inode->node);
+  kfree(inode);
+}
+
 inode_t *iget(dev_t dev, idx_t nr) {
   inode_t *inode = find_inode(dev, nr);
   if (inode) {
+    if (!inode->count) {
+      list_remove(&inode->rnode);
+      lru_count--;
+    }
     inode->count++;
     inode->atime = time();
     return inode;
@@ -61,14 +59,18 @@ inode_t *iget(dev_t dev, idx_t nr) {
 
   super_block_t *sb = get_super(dev);
   assert(sb);
-  assert(nr <= sb->desc->inodes);
+  assert(nr <= sb->inodes);
 
-  inode = get_free_inode();
+  inode = (inode_t *)kmalloc(sizeof(inode_t));
+  memset(inode, 0, sizeof(inode_t));
   inode->dev = dev;
   inode->nr = nr;
   inode->count++;
+  inode->extent = sb->extent;
+  inode->dlive = EOF;
+  rwlock_init(&inode->lock);
 
-  list_push(&sb->inode_list, &inode->node);
+  list_push(inode_hash(dev, nr), &inode->node);
 
   idx_t block = inode_block(sb, inode->nr);
   buffer_t *buf = bread(inode->dev, block);
@@ -95,25 +97,75 @@ void iput(inode_t *inode) {
     return;
   }
 
-  brelse(inode->buf);
-  list_remove(&inode->node);
-  put_free_inode(inode);
+  // Ѿɾ inode ٻ
+  if (!inode->nr || !inode->desc->nlinks) {
+    put_free_inode(inode);
+    return;
+  }
+
+  //  inode ڵĻ壬ٴδʱö
+  list_push(&lru_list, &inode->rnode);
+  if (++lru_count > INODE_LRU_MAX) {
+    inode_t *victim = element_entry(inode_t, rnode, list_popback(&lru_list));
+    lru_count--;
+    put_free_inode(victim);
+  }
 }
 
 void inode_init() {
-  for (size_t i = 0; i < INODE_NR; ++i) {
-    inode_t *inode = &inode_table[i];
-    inode->dev = EOF;
+  for (size_t i = 0; i < INODE_HASH_COUNT; ++i) {
+    list_init(&hash_table[i]);
   }
+  list_init(&lru_list);
+  lru_count = 0;
 }
 
-int inode_read(inode_t *inode, char *buf, uint32 len, off_t offset) {
+// ɢĶдλãԽα߽ʱƵһ
+typedef struct iov_iter_t {
+  iovec_t *iov;
+  uint32 skip; // ǰѾдֽ
+} iov_iter_t;
+
+static uint32 iov_length(iovec_t *iov, uint32 count) {
+  uint32 len = 0;
+  for (size_t i = 0; i < count; ++i) {
+    len += iov[i].len;
+  }
+  return len;
+}
+
+// ڿ黺 ptr ͷɢ֮临 chars ֽ
+static void iov_copy(iov_iter_t *iter, char *ptr, uint32 chars, bool to_iov) {
+  while (chars) {
+    iovec_t *iov = iter->iov;
+    uint32 n = MIN(iov->len - iter->skip, chars);
+    char *base = (char *)iov->base + iter->skip;
+    if (to_iov) {
+      memcpy(base, ptr, n);
+    } else {
+      memcpy(ptr, base, n);
+    }
+    ptr += n;
+    chars -= n;
+    iter->skip += n;
+
+    if (iter->skip == iov->len) {
+      iter->iov++;
+      iter->skip = 0;
+    }
+  }
+}
+
+int inode_readv(inode_t *inode, iovec_t *iov, uint32 count, off_t offset) {
+  read_lock(&inode->lock);
   if (offset >= inode->desc->size) {
+    read_unlock(&inode->lock);
     return EOF;
   }
   uint32 begin = offset;
+  iov_iter_t iter = {iov, 0};
 
-  uint32 left = MIN(len, inode->desc->size - offset);
+  uint32 left = MIN(iov_length(iov, count), inode->desc->size - offset);
   while (left) {
     // ļ
     idx_t nr = bmap(inode, offset / BLOCK_SIZE, false);
@@ -128,31 +180,34 @@ int inode_read(inode_t *inode, char *buf, uint32 len, off_t offset) {
     offset += chars;
     left -= chars;
 
-    char *ptr = bf->data + start;
-    memcpy(buf, ptr, chars);
-    buf += chars;
+    iov_copy(&iter, bf->data + start, chars, true);
     brelse(bf);
   }
 
   inode->atime = time();
+  read_unlock(&inode->lock);
   return offset - begin;
 }
 
-int inode_write(inode_t *inode, char *buf, uint32 len, off_t offset) {
+int inode_writev(inode_t *inode, iovec_t *iov, uint32 count, off_t offset) {
   assert(ISFILE(inode->desc->mode));
+  write_lock(&inode->lock);
 
   uint32 begin = offset;
-  uint32 left = len;
+  iov_iter_t iter = {iov, 0};
+  uint32 left = iov_length(iov, count);
 
+  // ûпռļʱֻдѾӳĲ
   while (left) {
     idx_t nr = bmap(inode, offset / BLOCK_SIZE, true);
-    assert(nr);
+    if (!nr) {
+      break;
+    }
 
     buffer_t *bf = bread(inode->dev, nr);
     bf->dirty = true;
 
     uint32 start = offset % BLOCK_SIZE;
-    char *ptr = bf->data + start;
 
     uint32 chars = MIN(BLOCK_SIZE - start, left);
     offset += chars;
@@ -163,16 +218,141 @@ int inode_write(inode_t *inode, char *buf, uint32 len, off_t offset) {
       inode->buf->dirty = true;
     }
 
-    memcpy(ptr, buf, chars);
-    buf += chars;
+    iov_copy(&iter, bf->data + start, chars, false);
     brelse(bf);
   }
 
   inode->desc->mtime = inode->atime = time();
   bwrite(inode->buf);
+  write_unlock(&inode->lock);
+  if (left && offset == begin) {
+    return EOF;
+  }
   return offset - begin;
 }
 
+int inode_read(inode_t *inode, char *buf, uint32 len, off_t offset) {
+  iovec_t iov = {buf, len};
+  return inode_readv(inode, &iov, 1, offset);
+}
+
+int inode_write(inode_t *inode, char *buf, uint32 len, off_t offset) {
+  iovec_t iov = {buf, len};
+  return inode_writev(inode, &iov, 1, offset);
+}
+
+//  inode ַ˳ʱȴ
+static void inode_copy_lock(inode_t *dst, inode_t *src) {
+  if (dst == src) {
+    write_lock(&dst->lock);
+  } else if (src < dst) {
+    read_lock(&src->lock);
+    write_lock(&dst->lock);
+  } else {
+    write_lock(&dst->lock);
+    read_lock(&src->lock);
+  }
+}
+
+static void inode_copy_unlock(inode_t *dst, inode_t *src) {
+  if (dst != src) {
+    read_unlock(&src->lock);
+  }
+  write_unlock(&dst->lock);
+}
+
+int inode_copy(inode_t *dst, off_t dst_offset, inode_t *src, off_t src_offset,
+               uint32 len) {
+  assert(ISFILE(dst->desc->mode));
+  // ͬһļص䲻ܰ˳
+  if (dst == src && src_offset < dst_offset + len &&
+      dst_offset < src_offset + len) {
+    return EOF;
+  }
+
+  inode_copy_lock(dst, src);
+  if (src_offset >= src->desc->size) {
+    inode_copy_unlock(dst, src);
+    return EOF;
+  }
+  uint32 begin = src_offset;
+  len = MIN(len, src->desc->size - src_offset);
+
+  idx_t snrs[COPY_BATCH];
+  idx_t dnrs[COPY_BATCH + 1];
+
+  while (len) {
+    // ÿӳ COPY_BATCH Դļ飬Ŀܶһ
+    idx_t sblock = src_offset / BLOCK_SIZE;
+    uint32 scount = (src_offset + len - 1) / BLOCK_SIZE - sblock + 1;
+    scount = MIN(scount, COPY_BATCH);
+    uint32 chunk = MIN(len, scount * BLOCK_SIZE - src_offset % BLOCK_SIZE);
+
+    idx_t dblock = dst_offset / BLOCK_SIZE;
+    uint32 dcount = (dst_offset + chunk - 1) / BLOCK_SIZE - dblock + 1;
+
+    bmap_range(src, sblock, scount, snrs, false);
+    bmap_range(dst, dblock, dcount, dnrs, true);
+
+    while (chunk) {
+      uint32 sstart = src_offset % BLOCK_SIZE;
+      uint32 dstart = dst_offset % BLOCK_SIZE;
+      uint32 chars = MIN(BLOCK_SIZE - MAX(sstart, dstart), chunk);
+
+      idx_t snr = snrs[src_offset / BLOCK_SIZE - sblock];
+      idx_t dnr = dnrs[dst_offset / BLOCK_SIZE - dblock];
+      if (!dnr) {
+        goto finish;
+      }
+
+      // 鸲ʱȴӴ̶Ŀ
+      buffer_t *dbf;
+      if (chars == BLOCK_SIZE) {
+        dbf = getblk(dst->dev, dnr);
+        lock_acquire(&dbf->lock);
+      } else {
+        dbf = bread(dst->dev, dnr);
+      }
+
+      // ԴļĿնΪ 0
+      if (snr) {
+        buffer_t *sbf = bread(src->dev, snr);
+        memcpy(dbf->data + dstart, sbf->data + sstart, chars);
+        brelse(sbf);
+      } else {
+        memset(dbf->data + dstart, 0, chars);
+      }
+
+      if (chars == BLOCK_SIZE) {
+        dbf->valid = true;
+        lock_release(&dbf->lock);
+      }
+      dbf->dirty = true;
+      brelse(dbf);
+
+      src_offset += chars;
+      dst_offset += chars;
+      chunk -= chars;
+      len -= chars;
+
+      if (dst_offset > dst->desc->size) {
+        dst->desc->size = dst_offset;
+        dst->buf->dirty = true;
+      }
+    }
+  }
+
+finish:
+  src->atime = time();
+  dst->desc->mtime = dst->atime = src->atime;
+  bwrite(dst->buf);
+  inode_copy_unlock(dst, src);
+  if (len && src_offset == begin) {
+    return EOF;
+  }
+  return src_offset - begin;
+}
+
 static void inode_bfree(inode_t *inode, uint16 *array, int index, int level) {
   if (!array[index]) {
     return;
@@ -194,6 +374,12 @@ void inode_truncate(inode_t *inode) {
   if (!ISFILE(inode->desc->mode) && !ISDIR(inode->desc->mode)) {
     return;
   }
+  write_lock(&inode->lock);
+
+  if (inode->extent) {
+    extent_truncate(inode);
+    goto reset;
+  }
 
   // ͷֱӿ
   for (size_t i = 0; i < DIRECT_BLOCK; ++i) {
@@ -208,8 +394,10 @@ void inode_truncate(inode_t *inode) {
   inode_bfree(inode, inode->desc->zone, DIRECT_BLOCK + 1, 2);
   inode->desc->zone[DIRECT_BLOCK + 1] = 0;
 
+reset:
   inode->desc->size = 0;
   inode->buf->dirty = true;
   inode->desc->mtime = time();
   bwrite(inode->buf);
+  write_unlock(&inode->lock);
 }
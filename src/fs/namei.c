@@ -5,6 +5,7 @@
 #include "../include/conix/stat.h"
 #include "../include/conix/string.h"
 #include "../include/conix/syscall.h"
+#include "../include/conix/task.h"
 
 #define P_EXEC 00001
 #define P_READ 00004
@@ -81,13 +82,381 @@ static bool match_name(const char *name, const char *entry_name, char **next) {
   return true;
 }
 
-// ȡdirĿ¼nameĿ¼ռdentry_tbuffer_t
-static buffer_t *find_entry(inode_t **dir, const char *name, char **next,
-                            dentry_t **result) {
+// Ŀ¼ 0 дΪϣ.  .. ֮λô
+// ҶӿճĿ¼ռһ dentry_tnr  name[0] Ϊ 0
+// ԱĿ¼ʱΪĿ¼
+#define DX_MAGIC 0x7864
+#define DX_LEVELS 1    // ֮һ
+#define DX_ROOT_SLOT 2 // ڵ 0 λ
+#define DX_ROOT_LIMIT (BLOCK_DENTRIES - DX_ROOT_SLOT - 1)
+#define DX_NODE_LIMIT (BLOCK_DENTRIES - 1)
+
+typedef struct dx_head_t {
+  uint16 nr;     //  0
+  uint8 zero;    //  0
+  uint8 levels;  // ֮ĲֻڸЧ
+  uint32 magic;
+  uint32 count;  // 
+  uint32 limit;  // 
+} dx_head_t;
+
+// ϣС hash Ŀ¼λĿ¼ĵ block 飬ֱһ
+typedef struct dx_entry_t {
+  uint16 nr;
+  uint8 zero;
+  uint8 reserved;
+  uint32 hash;
+  uint32 block;
+  uint32 unused;
+} dx_entry_t;
+
+// Ҿ
+typedef struct dx_frame_t {
+  buffer_t *buf;
+  dx_head_t *head;
+  dx_entry_t *entries;
+  dx_entry_t *at;
+} dx_frame_t;
+
+// Ŀ¼Ĺϣ strncpy ضϵһ£ȡ NAME_LEN ַ
+static uint32 dx_hash(const char *name) {
+  uint32 hash = 2166136261u;
+  for (size_t i = 0; i < NAME_LEN && name[i] && !IS_SEPARTOR(name[i]); ++i) {
+    hash = (hash ^ (name[i] & 0xff)) * 16777619u;
+  }
+  return hash;
+}
+
+// Ŀ¼йϣʱص 0 
+static buffer_t *dx_root(inode_t *dir) {
+  if (dir->desc->size <= BLOCK_SIZE) {
+    return NULL;
+  }
+  buffer_t *buf = bread(dir->dev, bmap(dir, 0, false));
+  dx_head_t *head = (dx_head_t *)buf->data + DX_ROOT_SLOT;
+  if (!head->nr && !head->zero && head->magic == DX_MAGIC) {
+    return buf;
+  }
+  brelse(buf);
+  return NULL;
+}
+
+// Ŀ¼ĩβ׷һĿ
+static buffer_t *dx_append(inode_t *dir, idx_t *block) {
+  assert(dir->desc->size % BLOCK_SIZE == 0);
+  *block = dir->desc->size / BLOCK_SIZE;
+  idx_t nr = bmap(dir, *block, true);
+  assert(nr);
+
+  buffer_t *buf = bread(dir->dev, nr);
+  memset(buf->data, 0, BLOCK_SIZE);
+  buf->dirty = true;
+
+  dir->desc->size += BLOCK_SIZE;
+  dir->buf->dirty = true;
+  return buf;
+}
+
+static dx_head_t *dx_node_init(buffer_t *buf, uint32 limit) {
+  dx_head_t *head = (dx_head_t *)buf->data;
+  head->magic = DX_MAGIC;
+  head->count = 0;
+  head->limit = limit;
+  return head;
+}
+
+// 𼶶ֲ hash ڵҶӣframes ¼
+static idx_t dx_probe(inode_t *dir, buffer_t *root, uint32 hash,
+                      dx_frame_t *frames, int *depth) {
+  dx_head_t *head = (dx_head_t *)root->data + DX_ROOT_SLOT;
+  uint32 levels = head->levels;
+  assert(levels <= DX_LEVELS);
+
+  buffer_t *buf = root;
+  for (uint32 level = 0; true; ++level) {
+    assert(head->magic == DX_MAGIC && head->count);
+    dx_frame_t *frame = &frames[level];
+    frame->buf = buf;
+    frame->head = head;
+    frame->entries = (dx_entry_t *)(head + 1);
+
+    //  0 иСĹϣ
+    int low = 1;
+    int high = head->count - 1;
+    frame->at = frame->entries;
+    while (low <= high) {
+      int mid = (low + high) / 2;
+      if (frame->entries[mid].hash <= hash) {
+        frame->at = &frame->entries[mid];
+        low = mid + 1;
+      } else {
+        high = mid - 1;
+      }
+    }
+
+    if (level == levels) {
+      *depth = level + 1;
+      return frame->at->block;
+    }
+    buf = bread(dir->dev, bmap(dir, frame->at->block, false));
+    head = (dx_head_t *)buf->data;
+  }
+}
+
+// ͷŸ֮µ飬ɵͷ
+static void dx_release(dx_frame_t *frames, int depth) {
+  for (int i = 1; i < depth; ++i) {
+    brelse(frames[i].buf);
+  }
+}
+
+//  frame->at ֮
+static void dx_insert(dx_frame_t *frame, uint32 hash, idx_t block) {
+  dx_head_t *head = frame->head;
+  assert(head->count < head->limit);
+
+  dx_entry_t *at = frame->at + 1;
+  for (dx_entry_t *ptr = frame->entries + head->count; ptr > at; --ptr) {
+    *ptr = *(ptr - 1);
+  }
+  memset(at, 0, sizeof(dx_entry_t));
+  at->hash = hash;
+  at->block = block;
+  head->count++;
+  frame->buf->dirty = true;
+}
+
+// дĵ 0 Ŀ¼ƵҶУ 0 Ϊ
+static void dx_make_index(inode_t *dir, buffer_t *root) {
+  idx_t block;
+  buffer_t *leaf = dx_append(dir, &block);
+
+  dentry_t *entries = (dentry_t *)root->data;
+  uint32 size = (BLOCK_DENTRIES - DX_ROOT_SLOT) * sizeof(dentry_t);
+  memcpy(leaf->data, &entries[DX_ROOT_SLOT], size);
+  memset(&entries[DX_ROOT_SLOT], 0, size);
+  brelse(leaf);
+
+  dx_head_t *head = (dx_head_t *)root->data + DX_ROOT_SLOT;
+  head->magic = DX_MAGIC;
+  head->levels = 0;
+  head->count = 1;
+  head->limit = DX_ROOT_LIMIT;
+
+  dx_entry_t *entry = (dx_entry_t *)(head + 1);
+  entry->hash = 0;
+  entry->block = block;
+  root->dirty = true;
+}
+
+// Ҷӵĸʱһ㣬԰飬
+// дʱ false
+static bool dx_grow(inode_t *dir, dx_frame_t *frames, int depth) {
+  dx_frame_t *root = &frames[0];
+  if (depth > 1 && root->head->count == root->head->limit) {
+    return false;
+  }
+
+  idx_t block;
+  buffer_t *buf = dx_append(dir, &block);
+  dx_head_t *head = dx_node_init(buf, DX_NODE_LIMIT);
+  dx_entry_t *entries = (dx_entry_t *)(head + 1);
+
+  if (depth == 1) {
+    memcpy(entries, root->entries, root->head->count * sizeof(dx_entry_t));
+    head->count = root->head->count;
+
+    root->head->levels++;
+    root->head->count = 1;
+    root->entries[0].hash = 0;
+    root->entries[0].block = block;
+    root->buf->dirty = true;
+  } else {
+    dx_frame_t *frame = &frames[depth - 1];
+    uint32 half = frame->head->count / 2;
+    head->count = frame->head->count - half;
+    memcpy(entries, frame->entries + half, head->count * sizeof(dx_entry_t));
+    frame->head->count = half;
+    frame->buf->dirty = true;
+
+    dx_insert(root, entries[0].hash, block);
+  }
+  brelse(buf);
+  return true;
+}
+
+// ϣдҶӶ԰ֿϣͬĿ¼ͬһҶ
+static void dx_split(inode_t *dir, dx_frame_t *frame, buffer_t *buf) {
+  dentry_t *entries = (dentry_t *)buf->data;
+  uint32 hashes[BLOCK_DENTRIES];
+  int order[BLOCK_DENTRIES];
+
+  for (int i = 0; i < BLOCK_DENTRIES; ++i) {
+    hashes[i] = dx_hash(entries[i].name);
+    int j = i;
+    for (; j > 0 && hashes[order[j - 1]] > hashes[i]; --j) {
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
+  }
+
+  int mid = BLOCK_DENTRIES / 2;
+  while (mid < BLOCK_DENTRIES &&
+         hashes[order[mid]] == hashes[order[mid - 1]]) {
+    mid++;
+  }
+  if (mid == BLOCK_DENTRIES) {
+    mid = BLOCK_DENTRIES / 2;
+    while (mid > 0 && hashes[order[mid]] == hashes[order[mid - 1]]) {
+      mid--;
+    }
+  }
+  assert(mid > 0 && mid < BLOCK_DENTRIES);
+
+  idx_t block;
+  buffer_t *nbuf = dx_append(dir, &block);
+  dentry_t *nentries = (dentry_t *)nbuf->data;
+  for (int i = mid; i < BLOCK_DENTRIES; ++i) {
+    nentries[i - mid] = entries[order[i]];
+    memset(&entries[order[i]], 0, sizeof(dentry_t));
+  }
+  buf->dirty = true;
+  brelse(nbuf);
+
+  dx_insert(frame, hashes[order[mid]], block);
+}
+
+static dentry_t *dx_match(buffer_t *buf, const char *name, char **next) {
+  dentry_t *entry = (dentry_t *)buf->data;
+  for (size_t i = 0; i < BLOCK_DENTRIES; ++i, ++entry) {
+    if (entry->nr && match_name(name, entry->name, next)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// ֻȡ·ϵĿһҶ
+static buffer_t *dx_lookup(inode_t *dir, buffer_t *root, const char *name,
+                           char **next, dentry_t **result) {
+  // .  .. ڵ 0 
+  dentry_t *entry = (dentry_t *)root->data;
+  for (size_t i = 0; i < DX_ROOT_SLOT; ++i, ++entry) {
+    if (entry->nr && match_name(name, entry->name, next)) {
+      *result = entry;
+      return root;
+    }
+  }
+
+  dx_frame_t frames[DX_LEVELS + 1];
+  int depth;
+  idx_t block = dx_probe(dir, root, dx_hash(name), frames, &depth);
+  dx_release(frames, depth);
+  brelse(root);
+
+  buffer_t *buf = bread(dir->dev, bmap(dir, block, false));
+  if ((*result = dx_match(buf, name, next))) {
+    return buf;
+  }
+  brelse(buf);
+  return NULL;
+}
+
+// ҵϣڵҶӣҶʱȷ²ңдʱ NULL
+static buffer_t *dx_add_entry(inode_t *dir, buffer_t *root, const char *name,
+                              dentry_t **result) {
+  uint32 hash = dx_hash(name);
+  dx_frame_t frames[DX_LEVELS + 1];
+  int depth;
+
+  while (true) {
+    idx_t block = dx_probe(dir, root, hash, frames, &depth);
+    buffer_t *buf = bread(dir->dev, bmap(dir, block, false));
+
+    dentry_t *entry = (dentry_t *)buf->data;
+    for (size_t i = 0; i < BLOCK_DENTRIES; ++i, ++entry) {
+      if (!entry->nr) {
+        dx_release(frames, depth);
+        brelse(root);
+        *result = entry;
+        return buf;
+      }
+    }
+
+    bool grown = true;
+    dx_frame_t *frame = &frames[depth - 1];
+    if (frame->head->count == frame->head->limit) {
+      grown = dx_grow(dir, frames, depth);
+    } else {
+      dx_split(dir, frame, buf);
+    }
+    brelse(buf);
+    dx_release(frames, depth);
+    if (!grown) {
+      brelse(root);
+      return NULL;
+    }
+  }
+}
+
+// һʹʱĿ¼ͳЧĿ¼͵һλ
+static void dir_stat(inode_t *dir) {
+  if (dir->dlive != EOF) {
+    return;
+  }
+
+  uint32 entries = dir->desc->size / sizeof(dentry_t);
+  buffer_t *buf = NULL;
+  dentry_t *entry = NULL;
+
+  dir->dlive = 0;
+  dir->dfree = entries;
+  for (idx_t i = 0; i < entries; ++i, ++entry) {
+    if (!buf || i % BLOCK_DENTRIES == 0) {
+      brelse(buf);
+      buf = bread(dir->dev, bmap(dir, i / BLOCK_DENTRIES, false));
+      entry = (dentry_t *)buf->data;
+    }
+    if (entry->nr) {
+      dir->dlive++;
+    } else if (dir->dfree == entries) {
+      dir->dfree = i;
+    }
+  }
+  brelse(buf);
+}
+
+// ɾ slot Ŀ¼slot Ϊ EOF ʱ¿λ
+static void dir_remove(inode_t *dir, buffer_t *buf, dentry_t *entry,
+                       idx_t slot) {
+  entry->nr = 0;
+  buf->dirty = true;
+
+  if (dir->dlive == EOF) {
+    return;
+  }
+  dir->dlive--;
+  if (slot != EOF && slot < dir->dfree) {
+    dir->dfree = slot;
+  }
+}
+
+// ȡdirĿ¼nameĿ¼ռdentry_tbuffer_t߳Ŀ¼
+static buffer_t *lookup_entry(inode_t **dir, const char *name, char **next,
+                              dentry_t **result, idx_t *slot) {
   assert((*dir)->desc->mode);
   // Ŀ¼ڳ
   // super_block_t *sb = read_super((*dir)->dev);
 
+  // Ŀ¼ʹÿλʾ
+  if (slot) {
+    *slot = EOF;
+  }
+  buffer_t *root = dx_root(*dir);
+  if (root) {
+    return dx_lookup(*dir, root, name, next, result);
+  }
+
   // Ŀ¼Ŀ¼
   uint32 entries = (*dir)->desc->size / sizeof(dentry_t);
 
@@ -105,8 +474,11 @@ static buffer_t *find_entry(inode_t **dir, const char *name, char **next,
       buf = bread((*dir)->dev, block);
       entry = (dentry_t *)buf->data;
     }
-    if (match_name(name, entry->name, next)) {
+    if (entry->nr && match_name(name, entry->name, next)) {
       *result = entry;
+      if (slot) {
+        *slot = i;
+      }
       return buf;
     }
   }
@@ -115,29 +487,68 @@ static buffer_t *find_entry(inode_t **dir, const char *name, char **next,
   return NULL;
 }
 
-static buffer_t *add_entry(inode_t *dir, const char *name, dentry_t **result) {
+// ʱĿ¼ͬʱ·
+static buffer_t *find_entry(inode_t **dir, const char *name, char **next,
+                            dentry_t **result) {
+  inode_t *inode = *dir;
+  read_lock(&inode->lock);
+  buffer_t *buf = lookup_entry(dir, name, next, result, NULL);
+  read_unlock(&inode->lock);
+  return buf;
+}
+
+// ޸Ŀ¼ҪռĿ¼д inode  nr ֮ͷţ
+// ͬĿ¼Ѿڻʱ NULL
+static buffer_t *add_entry(inode_t *dir, const char *name, idx_t nr,
+                           dentry_t **result) {
+  write_lock(&dir->lock);
+
   char *next = NULL;
-  buffer_t *buf = find_entry(&dir, name, &next, result);
+  buffer_t *buf = lookup_entry(&dir, name, &next, result, NULL);
   if (buf) {
-    return buf;
+    brelse(buf);
+    write_unlock(&dir->lock);
+    return NULL;
   }
 
   for (size_t i = 0; i < NAME_LEN && name[i]; ++i) {
     assert(!IS_SEPARTOR(name[i]));
   }
 
-  idx_t i = 0;
-  idx_t block = 0;
   dentry_t *entry;
+  dir_stat(dir);
+
+  buffer_t *root = dx_root(dir);
+  if (root) {
+    buf = dx_add_entry(dir, root, name, &entry);
+    if (!buf) {
+      write_unlock(&dir->lock);
+      return NULL;
+    }
+    goto fill;
+  }
+
+  // ӵһܿеλÿʼ
+  idx_t i = dir->dfree;
+  idx_t block = 0;
 
   for (; true; ++i, ++entry) {
-    if (!buf || (uint32)entry >= (uint32)buf->data + BLOCK_SIZE) {
+    //  0 дʱϣ
+    if (i == BLOCK_DENTRIES && dir->desc->size == BLOCK_SIZE) {
+      if (!buf) {
+        buf = bread(dir->dev, bmap(dir, 0, false));
+      }
+      dx_make_index(dir, buf);
+      buf = dx_add_entry(dir, buf, name, &entry);
+      goto fill;
+    }
+    if (!buf || i % BLOCK_DENTRIES == 0) {
       brelse(buf);
       block = bmap(dir, i / BLOCK_DENTRIES, true);
       assert(block);
 
       buf = bread(dir->dev, block);
-      entry = (dentry_t *)buf->data;
+      entry = (dentry_t *)buf->data + i % BLOCK_DENTRIES;
     }
     if (i * sizeof(dentry_t) >= dir->desc->size) {
       entry->nr = 0;
@@ -145,18 +556,41 @@ static buffer_t *add_entry(inode_t *dir, const char *name, dentry_t **result) {
       dir->buf->dirty = true;
     }
 
-    if (entry->nr) {
-      continue;
+    if (!entry->nr) {
+      dir->dfree = i + 1;
+      break;
     }
+  }
 
-    strncpy(entry->name, name, NAME_LEN);
-    buf->dirty = true;
-    dir->desc->mtime = time();
-    dir->buf->dirty = true;
+fill:
+  strncpy(entry->name, name, NAME_LEN);
+  entry->nr = nr;
+  dir->dlive++;
+  buf->dirty = true;
+  dir->desc->mtime = time();
+  dir->buf->dirty = true;
 
-    *result = entry;
-    return buf;
+  *result = entry;
+  write_unlock(&dir->lock);
+  return buf;
+}
+
+// ֮Ŀ¼Ѿ仯д²Ҳɾָ nr Ŀ¼
+static bool del_entry(inode_t *dir, const char *name, idx_t nr) {
+  write_lock(&dir->lock);
+
+  char *next = NULL;
+  dentry_t *entry;
+  idx_t slot;
+  buffer_t *buf = lookup_entry(&dir, name, &next, &entry, &slot);
+  bool found = buf && entry->nr == nr;
+  if (found) {
+    dir_remove(dir, buf, entry, slot);
   }
+  brelse(buf);
+
+  write_unlock(&dir->lock);
+  return found;
 }
 
 // ļ·ӦĸĿ¼
@@ -267,12 +701,15 @@ int sys_mkdir(char *pathname, int mode) {
     goto rollback;
   }
 
-  ebuf = add_entry(dir, name, &entry);
-  ebuf->dirty = true;
-  entry->nr = ialloc(dir->dev);
+  idx_t nr = ialloc(dir->dev);
+  ebuf = add_entry(dir, name, nr, &entry);
+  if (!ebuf) {
+    ifree(dir->dev, nr);
+    goto rollback;
+  }
 
   task_t *task = running_task();
-  inode_t *inode = iget(dir->dev, entry->nr);
+  inode_t *inode = iget(dir->dev, nr);
   inode->buf->dirty = true;
 
   inode->desc->gid = task->gid;
@@ -298,6 +735,9 @@ int sys_mkdir(char *pathname, int mode) {
   strcpy(entry->name, "..");
   entry->nr = dir->nr;
 
+  inode->dlive = 2;
+  inode->dfree = 2;
+
   iput(inode);
   iput(dir);
 
@@ -314,36 +754,9 @@ rollback:
 static bool is_empty(inode_t *inode) {
   assert(ISDIR(inode->desc->mode));
 
-  //  ...
-  int entries = inode->desc->size / sizeof(dentry_t);
-  if (entries < 2 || !inode->desc->zone[0]) {
-    return false;
-  }
-
-  idx_t i = 0;
-  idx_t block = 0;
-  buffer_t *buf = NULL;
-  dentry_t *entry;
-  int count = 0;
-  for (; i < entries; ++i) {
-    if (!buf || (uint32)entry >= (uint32)buf->data + BLOCK_SIZE) {
-      brelse(buf);
-      block = bmap(inode, i / BLOCK_DENTRIES, false);
-
-      buf = bread(inode->dev, block);
-      entry = (dentry_t *)buf->data;
-    }
-    if (entry->nr) {
-      count++;
-    }
-  }
-
-  brelse(buf);
-  if (count < 2) {
-    return false;
-  }
-
-  return count == 2;
+  // ֻ ...
+  dir_stat(inode);
+  return inode->dlive == 2;
 }
 
 int sys_rmdir(char *pathname) {
@@ -386,6 +799,9 @@ int sys_rmdir(char *pathname) {
   if (!is_empty(inode)) {
     goto rollback;
   }
+  if (!del_entry(dir, name, inode->nr)) {
+    goto rollback;
+  }
 
   assert(inode->desc->nlinks == 2);
 
@@ -400,9 +816,6 @@ int sys_rmdir(char *pathname) {
   dir->ctime = dir->atime = dir->desc->mtime = time();
   dir->buf->dirty = true;
 
-  entry->nr = 0;
-  ebuf->dirty = true;
-
   ret = 0;
 
 rollback:
@@ -446,9 +859,10 @@ int sys_link(char *oldname, char *newname) {
     goto rollback;
   }
 
-  buf = add_entry(dir, name, &entry);
-  entry->nr = inode->nr;
-  buf->dirty = true;
+  buf = add_entry(dir, name, inode->nr, &entry);
+  if (!buf) {
+    goto rollback;
+  }
 
   inode->desc->nlinks++;
   inode->ctime = time();
@@ -499,8 +913,9 @@ int sys_unlink(char *filename) {
     DEBUGK("non exists file\n");
   }
 
-  entry->nr = 0;
-  buf->dirty = true;
+  if (!del_entry(dir, name, inode->nr)) {
+    goto rollback;
+  }
 
   inode->desc->nlinks--;
   inode->buf->dirty = true;
@@ -552,9 +967,13 @@ inode_t *inode_open(char *pathname, int flag, int mode) {
     goto rollback;
   }
 
-  buf = add_entry(dir, name, &entry);
-  entry->nr = ialloc(dir->dev);
-  inode = iget(dir->dev, entry->nr);
+  idx_t nr = ialloc(dir->dev);
+  buf = add_entry(dir, name, nr, &entry);
+  if (!buf) {
+    ifree(dir->dev, nr);
+    goto rollback;
+  }
+  inode = iget(dir->dev, nr);
 
   task_t *task = running_task();
   mode &= (0777 & ~task->umask);
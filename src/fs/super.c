@@ -9,6 +9,8 @@
 static super_block_t super_table[SUPER_NR];
 static super_block_t *root; // ļϵͳ
 
+extern void inode_init();
+
 static super_block_t *get_free_super() {
   for (size_t i = 0; i < SUPER_NR; ++i) {
     super_block_t *sb = &super_table[i];
@@ -40,14 +42,32 @@ super_block_t *read_super(dev_t dev) {
   sb->buf = buf;
   sb->desc = (super_desc_t *)buf->data;
   sb->dev = dev;
-  assert(sb->desc->magic == MINIX1_MAGIC);
+  rwlock_init(&sb->lock);
+
+  if (sb->desc->magic == EXTENT_MAGIC) {
+    extent_super_desc_t *desc = (extent_super_desc_t *)buf->data;
+    sb->extent = true;
+    sb->inodes = desc->inodes;
+    sb->zones = desc->zones;
+    sb->firstdatazone = desc->firstdatazone;
+    sb->imap_blocks = desc->imap_blocks;
+    sb->zmap_blocks = desc->zmap_blocks;
+  } else {
+    assert(sb->desc->magic == MINIX1_MAGIC);
+    sb->extent = false;
+    sb->inodes = sb->desc->inodes;
+    sb->zones = sb->desc->zones;
+    sb->firstdatazone = sb->desc->firstdatazone;
+    sb->imap_blocks = sb->desc->imap_blocks;
+    sb->zmap_blocks = sb->desc->zmap_blocks;
+  }
+  assert(sb->imap_blocks <= IMAP_NR);
 
   memset(sb->imap, 0, sizeof(sb->imap));
   memset(sb->zmap, 0, sizeof(sb->zmap));
 
   int idx = 2;
-  for (int i = 0; i < sb->desc->imap_blocks; ++i) {
-    assert(i < IMAP_NR);
+  for (int i = 0; i < sb->imap_blocks; ++i) {
     if ((sb->imap[i] = bread(dev, idx))) {
       idx++;
     } else {
@@ -55,8 +75,9 @@ super_block_t *read_super(dev_t dev) {
     }
   }
 
-  for (int i = 0; i < sb->desc->zmap_blocks; ++i) {
-    assert(i < ZMAP_NR);
+  // ļϵͳ߼λͼֻܴܺפǰ ZMAP_NR 
+  assert(sb->extent || sb->zmap_blocks <= ZMAP_NR);
+  for (int i = 0; i < sb->zmap_blocks && i < ZMAP_NR; ++i) {
     if ((sb->zmap[i] = bread(dev, idx))) {
       idx++;
     } else {
@@ -67,9 +88,16 @@ super_block_t *read_super(dev_t dev) {
   return sb;
 }
 
+// ûиļϵͳʱĸĿ¼͵ǰĿ¼ָ inode
+static inode_t root_inode;
+
+inode_t *get_root_inode() { return root ? root->iroot : &root_inode; }
+
 static void mount_root() {
   device_t *device = device_find(DEV_IDE_PART, 0);
-  assert(device);
+  if (!device) {
+    return;
+  }
   root = read_super(device->dev);
 
   // ʼĿ¼inode
@@ -85,8 +113,8 @@ void super_init() {
     sb->buf = NULL;
     sb->iroot = NULL;
     sb->imount = NULL;
-    list_init(&sb->inode_list);
   }
 
+  inode_init();
   mount_root();
 }
\ No newline at end of file
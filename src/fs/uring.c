@@ -0,0 +1,234 @@
+#include "../include/conix/uring.h"
+#include "../include/conix/arena.h"
+#include "../include/conix/assert.h"
+#include "../include/conix/buffer.h"
+#include "../include/conix/debug.h"
+#include "../include/conix/fs.h"
+#include "../include/conix/list.h"
+#include "../include/conix/memory.h"
+#include "../include/conix/task.h"
+#include "../include/conix/wait.h"
+
+#define LOG_DEBUG(fmt, args...) DEBUGK(fmt, ##args)
+
+// עĻ
+typedef struct uring_ctx_t {
+  uring_t *ring;     // ûռַֻ owner ĵַռз
+  task_t *owner;
+  list_node_t node;  // ȴ̴߳ڵ
+  bool queued;       // ڵȴ
+  bool running;      // ߳ڴ
+  wait_queue_t wait; // ȴɵĽ
+} uring_ctx_t;
+
+static list_t uring_list;       // ύĻ
+static wait_queue_t uring_wait; // ߳ȴ
+
+extern fd_t file_open(task_t *task, char *filename, int flags, int mode);
+extern void file_close(task_t *task, fd_t fd);
+
+static file_t *uring_file(task_t *task, fd_t fd) {
+  if (fd <= stderr) {
+    return NULL;
+  }
+  return task_file(task, fd);
+}
+
+//  owner ִһύֵӦϵͳͬ
+static int32 uring_execute(task_t *owner, uring_sqe_t *sqe) {
+  file_t *file = NULL;
+  int32 len;
+
+  switch (sqe->opcode) {
+  case URING_NOP:
+    return 0;
+  case URING_OPEN:
+    return file_open(owner, sqe->buf, sqe->flags, sqe->mode);
+  case URING_CLOSE:
+    if (!uring_file(owner, sqe->fd)) {
+      return EOF;
+    }
+    file_close(owner, sqe->fd);
+    return 0;
+  default:
+    break;
+  }
+
+  file = uring_file(owner, sqe->fd);
+  if (!file) {
+    return EOF;
+  }
+
+  off_t offset = sqe->offset;
+  if (offset == URING_OFFSET_CUR) {
+    offset = file->offset;
+  }
+
+  switch (sqe->opcode) {
+  case URING_READ:
+    if ((file->flags & O_ACCMODE) == O_WRONLY) {
+      return EOF;
+    }
+    len = inode_read(file->inode, sqe->buf, sqe->len, offset);
+    break;
+  case URING_WRITE:
+    if ((file->flags & O_ACCMODE) == O_RDONLY) {
+      return EOF;
+    }
+    len = inode_write(file->inode, sqe->buf, sqe->len, offset);
+    break;
+  case URING_FSYNC:
+    // ݿ brelse ʱѾдأֻд inode
+    write_lock(&file->inode->lock);
+    file->inode->buf->dirty = true;
+    bwrite(file->inode->buf);
+    write_unlock(&file->inode->lock);
+    return 0;
+  default:
+    return EOF;
+  }
+
+  if (len != EOF && sqe->offset == URING_OFFSET_CUR) {
+    file->offset += len;
+  }
+  return len;
+}
+
+// ύеĴС˵ sq_tail Ч
+static bool uring_sq_valid(uring_t *ring) {
+  return ring->sq_tail - ring->sq_head <= URING_ENTRIES;
+}
+
+//  owner ĵַռ䡢ݺļϵͳģеύ
+// ɶʱͣ£ʣύ´νʱ
+static void uring_run(uring_ctx_t *ctx) {
+  task_t *task = running_task();
+  task_t *owner = ctx->owner;
+  uint32 pde = task->pde;
+  bitmap_t *vmap = task->vmap;
+  uint32 brk = task->brk;
+  inode_t *ipwd = task->ipwd;
+  inode_t *iroot = task->iroot;
+  uint16 umask = task->umask;
+  uint32 uid = task->uid;
+  uint32 gid = task->gid;
+
+  task->pde = owner->pde;
+  task->vmap = owner->vmap;
+  task->brk = owner->brk;
+  task->ipwd = owner->ipwd;
+  task->iroot = owner->iroot;
+  task->umask = owner->umask;
+  task->uid = owner->uid;
+  task->gid = owner->gid;
+  set_cr3(task->pde);
+
+  uring_t *ring = ctx->ring;
+  while (ring->sq_head != ring->sq_tail && uring_sq_valid(ring) &&
+         ring->cq_tail - ring->cq_head < URING_ENTRIES) {
+    // ûͬʱ޸ύȸƳ
+    uring_sqe_t sqe = ring->sqes[ring->sq_head & (URING_ENTRIES - 1)];
+    ring->sq_head++;
+
+    int32 result = uring_execute(owner, &sqe);
+
+    uring_cqe_t *cqe = &ring->cqes[ring->cq_tail & (URING_ENTRIES - 1)];
+    cqe->data = sqe.data;
+    cqe->result = result;
+    ring->cq_tail++;
+    wake_up_all(&ctx->wait);
+  }
+
+  task->pde = pde;
+  task->vmap = vmap;
+  task->brk = brk;
+  task->ipwd = ipwd;
+  task->iroot = iroot;
+  task->umask = umask;
+  task->uid = uid;
+  task->gid = gid;
+  set_cr3(task->pde);
+}
+
+void uring_thread() {
+  while (true) {
+    wait_event(&uring_wait, !list_empty(&uring_list));
+
+    uring_ctx_t *ctx =
+        element_entry(uring_ctx_t, node, list_popback(&uring_list));
+    ctx->queued = false;
+    ctx->running = true;
+    uring_run(ctx);
+    ctx->running = false;
+    wake_up_all(&ctx->wait);
+  }
+}
+
+// עûռеĻÿһ
+int sys_uring_setup(uring_t *ring) {
+  task_t *task = running_task();
+  if (task->uring || !ring || (uint32)ring < KERNEL_MEMORY_SIZE ||
+      (uint32)ring + sizeof(uring_t) > USER_STACK_TOP) {
+    return EOF;
+  }
+
+  uring_ctx_t *ctx = kmalloc(sizeof(uring_ctx_t));
+  ctx->ring = ring;
+  ctx->owner = task;
+  ctx->node.next = ctx->node.prev = NULL;
+  ctx->queued = false;
+  ctx->running = false;
+  wait_queue_init(&ctx->wait);
+
+  ring->sq_head = ring->sq_tail = 0;
+  ring->cq_head = ring->cq_tail = 0;
+
+  task->uring = ctx;
+  return 0;
+}
+
+// ̴֪ͨ߳µύȴ min_complete 
+// ؿո
+int sys_uring_enter(uint32 min_complete) {
+  task_t *task = running_task();
+  uring_ctx_t *ctx = task->uring;
+  if (!ctx || min_complete > URING_ENTRIES) {
+    return EOF;
+  }
+
+  uring_t *ring = ctx->ring;
+  if (!uring_sq_valid(ring)) {
+    return EOF;
+  }
+  if (ring->sq_head != ring->sq_tail && !ctx->queued && !ctx->running) {
+    list_insert_after(&uring_list.head, &ctx->node);
+    ctx->queued = true;
+    wake_up(&uring_wait);
+  }
+
+  // ߳ͣʱٵȴɶʱʣύ´
+  wait_event(&ctx->wait, ring->cq_tail - ring->cq_head >= min_complete ||
+                             (!ctx->queued && !ctx->running));
+  return ring->cq_tail - ring->cq_head;
+}
+
+void uring_exit(task_t *task) {
+  uring_ctx_t *ctx = task->uring;
+  if (!ctx) {
+    return;
+  }
+
+  if (ctx->queued) {
+    list_remove(&ctx->node);
+    ctx->queued = false;
+  }
+  wait_event(&ctx->wait, !ctx->running);
+
+  task->uring = NULL;
+  kfree(ctx);
+}
+
+void uring_init() {
+  list_init(&uring_list);
+  wait_queue_init(&uring_wait);
+}
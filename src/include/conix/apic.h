@@ -0,0 +1,38 @@
+#ifndef CONIX_APIC_H
+#define CONIX_APIC_H
+
+#include "types.h"
+
+#define LAPIC_BASE 0xFEE00000
+#define IOAPIC_BASE 0xFEC00000
+
+// ж 8259  16 ֮
+#define LAPIC_TIMER_VECTOR 0x30 //  APIC ʱ
+#define IPI_RESCHEDULE 0x31     // ֪ͨ CPU µ
+#define LAPIC_SPURIOUS 0x3f     // αж
+
+// ǷѾ 8259 л APIC
+extern bool apic_enabled;
+
+void lapic_init();
+uint32 lapic_id();
+void lapic_eoi();
+
+// У׼ APIC ʱӣõÿ jiffy ļ
+void lapic_timer_calibrate();
+// ÿ jiffy һ LAPIC_TIMER_VECTOR ж
+void lapic_timer_init();
+
+void lapic_send_ipi(uint32 apic_id, uint32 vector);
+//  INIT  STARTUP addr ʵģʽ
+void lapic_startup(uint32 apic_id, uint32 addr);
+
+void ioapic_init(uint32 addr);
+// ж irq  IOAPIC  pin ͵ apic_id ·ɺ״̬
+void ioapic_route(uint32 irq, uint32 pin, uint32 flags, uint32 apic_id);
+void ioapic_mask(uint32 irq, bool enable);
+
+//  8259 IOAPIC ַж
+void apic_enable();
+
+#endif
@@ -19,4 +19,7 @@ void bitmap_set(bitmap_t *map, idx_t index, bool value);
 
 int bitmap_scan(bitmap_t *map, uint32 count);
 
+//  index ʼҵһλ 1û򷵻 EOF
+int bitmap_alloc(bitmap_t *map, idx_t index);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef CONIX_CPU_H
+#define CONIX_CPU_H
+
+#include "types.h"
+
+// CPUID EAX=1 ʱ EDX еĹλ
+#define CPU_FEATURE_PSE (1 << 3)  // 4M ҳ
+#define CPU_FEATURE_TSC (1 << 4)  // ʱ
+#define CPU_FEATURE_APIC (1 << 9) //  APIC
+#define CPU_FEATURE_SEP (1 << 11) // sysenter / sysexit
+#define CPU_FEATURE_PGE (1 << 13) // ȫҳ
+
+// sysenter ʹõ MSR
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+// CR4 λ
+#define CR4_PSE (1 << 4) //  4M ҳ
+#define CR4_PGE (1 << 7) // ȫҳ
+
+// Ƿ֧ cpuid ָ
+bool cpuid_support();
+void cpuid(uint32 leaf, uint32 *eax, uint32 *ebx, uint32 *ecx, uint32 *edx);
+
+//  CPU Ƿ֧ feature 
+bool cpu_has(uint32 feature);
+
+// ȡʱ
+uint64 rdtsc();
+
+// ԭӵؽ *addr  valueԭֵ
+uint32 xchg(volatile uint32 *addr, uint32 value);
+// ȴʱ͹
+void cpu_relax();
+
+uint64 rdmsr(uint32 msr);
+void wrmsr(uint32 msr, uint64 value);
+
+uint32 get_cr4();
+void set_cr4(uint32 cr4);
+
+#endif
@@ -2,12 +2,14 @@
 #define CONIX_FS_H
 
 #include "list.h"
+#include "mutex.h"
 #include "types.h"
 
 #define BLOCK_SIZE 1024
 #define SECTOR_SIZE 512
 
 #define MINIX1_MAGIC 0x137f
+#define EXTENT_MAGIC 0x4578 // ļϵͳinode ¼߼
 #define NAME_LEN 14
 
 #define IMAP_NR 8
@@ -23,6 +25,10 @@
 #define INDIRECT2_BLOCK (INDIRECT1_BLOCK * INDIRECT1_BLOCK)
 #define TOTAL_BLOCK (DIRECT_BLOCK + INDIRECT1_BLOCK + INDIRECT2_BLOCK)
 
+#define EXTENT_MAX (BLOCK_SIZE / sizeof(extent_t)) // ɵ
+
+#define IOV_MAX 1024 // ɢд
+
 #define SEPARTOR1 '/'
 #define SEPARTOR2 '\\'
 #define IS_SEPARTOR(c) (c == SEPARTOR1 || c == SEPARTOR2)
@@ -50,6 +56,26 @@ typedef struct inode_desc_t {
   uint16 zone[9]; // ֱ0-67˫ؼ8 ߼
 } inode_desc_t;
 
+// ļ block ʼ count ߼ start ʼ
+typedef struct extent_t {
+  uint32 block;
+  uint32 start;
+  uint32 count;
+} extent_t;
+
+// ļϵͳ inodeǰ 14 ֽ inode_desc_t ͬ
+typedef struct extent_inode_desc_t {
+  uint16 mode;
+  uint16 uid;
+  uint32 size;
+  uint32 mtime;
+  uint8 gid;
+  uint8 nlinks;
+  uint16 extents;     // 
+  uint32 eblock;      // 飬䰴ļ
+  uint16 reserved[6];
+} extent_inode_desc_t;
+
 typedef struct inode_t {
   inode_desc_t *desc;
   struct buffer_t *buf;
@@ -58,8 +84,13 @@ typedef struct inode_t {
   uint32 count; // ü
   time_t atime; // ʱ
   time_t ctime; // ޸ʱ
-  list_node_t node;
-  dev_t mount; // ص豸
+  list_node_t node;  // ϣڵ
+  list_node_t rnode; // δʱλ LRU 
+  dev_t mount;  // ص豸
+  bool extent;  // desc Ϊ extent_inode_desc_t
+  int32 dlive;  // Ŀ¼ЧĿ¼EOF ʾδͳ
+  idx_t dfree;  // Ŀ¼һܿеĿ¼
+  rwlock_t lock; // ļݺĿ¼
 } inode_t;
 
 typedef struct super_desc_t {
@@ -73,15 +104,33 @@ typedef struct super_desc_t {
   uint16 magic;
 } super_desc_t;
 
+// ļϵͳĳ飬߼Ϊ 32 λmagic  minix ƫͬ
+typedef struct extent_super_desc_t {
+  uint32 inodes;
+  uint32 zones;
+  uint16 imap_blocks;
+  uint16 zmap_blocks;
+  uint32 firstdatazone;
+  uint16 magic;
+  uint16 reserved;
+  uint32 max_size;
+} extent_super_desc_t;
+
 typedef struct super_block_t {
   super_desc_t *desc;
   struct buffer_t *buf;
   struct buffer_t *imap[IMAP_NR];
   struct buffer_t *zmap[ZMAP_NR];
   dev_t dev;
-  list_t inode_list; // 򿪵inode
+  bool extent;          // ļϵͳ
+  uint32 inodes;        // ´ֳ
+  uint32 zones;
+  uint32 firstdatazone;
+  uint16 imap_blocks;
+  uint16 zmap_blocks;
   inode_t *iroot;    // Ŀ¼inode
   inode_t *imount;
+  rwlock_t lock; //  inode ߼λͼ
 } super_block_t;
 
 typedef struct dentry_t {
@@ -108,10 +157,18 @@ super_block_t *read_super(dev_t dev);
 
 // λͼ
 idx_t balloc(dev_t dev);
+// ȷ goal Ŀп飬ļ
+idx_t balloc_near(dev_t dev, idx_t goal);
 void bfree(dev_t dev, idx_t idx);
 idx_t ialloc(dev_t dev);
 void ifree(dev_t dev, idx_t idx);
 idx_t bmap(inode_t *inode, idx_t block, bool create);
+// ӳ block ʼ count ļ鵽 nrsͬһӿֻȡһ
+void bmap_range(inode_t *inode, idx_t block, uint32 count, idx_t *nrs,
+                bool create);
+// ļϵͳӳͷ
+idx_t extent_bmap(inode_t *inode, idx_t block, bool create);
+void extent_truncate(inode_t *inode);
 
 inode_t *get_root_inode(); // Ŀ¼inode
 inode_t *iget(dev_t dev, idx_t nr);
@@ -123,6 +180,12 @@ inode_t *namei(char *pathname);
 inode_t *inode_open(char *pathname, int flag, int mode);
 int inode_read(inode_t *inode, char *buf, uint32 len, off_t offset);
 int inode_write(inode_t *inode, char *buf, uint32 len, off_t offset);
+// һαļ飬ζд count λ
+int inode_readv(inode_t *inode, iovec_t *iov, uint32 count, off_t offset);
+int inode_writev(inode_t *inode, iovec_t *iov, uint32 count, off_t offset);
+//  src  src_offset ʼ len ֽڸƵ dst  dst_offset
+int inode_copy(inode_t *dst, off_t dst_offset, inode_t *src, off_t src_offset,
+               uint32 len);
 void inode_truncate(inode_t *inode);
 
 #endif
\ No newline at end of file
@@ -5,12 +5,16 @@
 
 #define GDT_SIZE 128
 
+// sysexit Ҫûκݶνں˴κݶ֮
 #define KERNEL_CODE_IDX 1
 #define KERNEL_DATA_IDX 2
-#define KERNEL_TSS_IDX 3
+#define USER_CODE_IDX 3
+#define USER_DATA_IDX 4
 
-#define USER_CODE_IDX 4
-#define USER_DATA_IDX 5
+#define KERNEL_TSS_IDX 5
+
+// Ӧô TSS ￪ʼÿһ
+#define CPU_TSS_IDX 6
 
 #define KERNEL_CODE_SELECTOR (KERNEL_CODE_IDX << 3)
 #define KERNEL_DATA_SELECTOR (KERNEL_DATA_IDX << 3)
@@ -82,5 +86,7 @@ typedef struct tss_t {
 } _packed tss_t;
 
 void gdt_init();
+// ʼ tss Ϊ gdt  idx صǰ
+void tss_load(tss_t *tss, uint32 idx);
 
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "mutex.h"
 #include "task.h"
 #include "types.h"
+#include "wait.h"
 
 #define SECTOR_SIZE 512
 
@@ -53,7 +54,7 @@ typedef struct ide_ctrl_t {
   uint16 iobase; // IO Ĵַ
   ide_disk_t disks[IDE_DISK_NR];
   ide_disk_t *active;
-  struct task_t *waiter;
+  wait_queue_t wait; // ȴжϵĽ
 } ide_ctrl_t;
 
 int ide_pio_read(ide_disk_t *disk, void *buf, uint8 count, idx_t lba);
@@ -0,0 +1,63 @@
+#ifndef CONIX_KSTAT_H
+#define CONIX_KSTAT_H
+
+#include "types.h"
+
+// ںͳϢ
+typedef enum kstat_type_t {
+  KSTAT_TLB = 1,
+  KSTAT_FAULT, // ǰ
+  KSTAT_SCHED,
+  KSTAT_IDLE,
+  KSTAT_LOCK, // л֮
+} kstat_type_t;
+
+typedef struct tlb_stat_t {
+  uint32 cr3_reloads; // CR3 ش
+  uint32 invlpgs;     // invlpg 
+  uint32 cr3_rate;    // һ CR3 ش
+  uint32 invlpg_rate; // һ invlpg 
+} tlb_stat_t;
+
+typedef struct fault_stat_t {
+  uint32 faults; // ȱҳ쳣
+  uint32 pages;  // ȱҳʱӳҳ
+  uint32 window; // ǰԤӳ䴰ҳ
+  uint32 next;   // Ԥһȱҳĵַ
+} fault_stat_t;
+
+// ʱ䵥λΪ TSC 
+typedef struct sched_stat_t {
+  uint32 switches;    // л
+  uint32 pick;        // һѡĺʱ
+  uint32 pick_max;    // ѡʱ
+  uint32 latency;     // һδӾеӳ
+  uint32 latency_max; // Ӿеӳ
+} sched_stat_t;
+
+// ͳƣʱ䵥λΪ TSC 
+typedef struct lock_stat_t {
+  uint32 acquisitions; // 
+  uint32 contended;    // ʱѱеĴ
+  uint32 spins;        // ȵͷŵĴ
+  uint32 wait;         // ȴʱ
+  uint32 wait_max;     // һεȴ
+} lock_stat_t;
+
+// 0x20 ʼ 8259 жϣԼ APIC ʱӺʹж
+#define IDLE_IRQ_NR 32
+
+// ʱ䵥λΪ
+typedef struct idle_stat_t {
+  uint32 cpus;                 // ߵ CPU 
+  uint32 uptime;               // ʱ
+  uint32 idle;                 //  CPU еʱ֮
+  uint32 idle_rate;            // һ CPU еʱ
+  uint32 halts;                // hlt 
+  uint32 wakeups[IDLE_IRQ_NR]; // ж CPU Ĵ
+} idle_stat_t;
+
+// ÿһ
+void kstat_tick();
+
+#endif
@@ -22,6 +22,15 @@
 #define USER_STACK_SIZE 0x200000
 #define USER_STACK_BOTTOM (USER_STACK_TOP - USER_STACK_SIZE)
 
+// ҳˢ TLB ޣ cr3
+#define TLB_FLUSH_MAX 32
+
+// brk չʱԤӳҳ
+#define BRK_PREFAULT 16
+
+// ȱҳʱӳҳ
+#define FAULT_AROUND_MAX 16
+
 // ںҳĿ¼ַ
 #define KERNEL_PAGE_DIR 0x1000
 // ںҳ
@@ -55,6 +64,8 @@ uint32 get_cr2();
 uint32 get_cr3();
 // ҳĿ¼ַ
 void set_cr3(uint32 pde);
+// ǰ TLB ҳĿ¼ں߳̽һĵַռ
+uint32 get_active_pde();
 
 // countںҳ
 uint32 alloc_kpage(uint32 count);
@@ -63,9 +74,27 @@ void free_kpage(uint32 vaddr, uint32 count);
 
 // vaddrӳڴ
 void link_page(uint32 vaddr);
+// ں˺ӳ豸Ĵҳн̹
+void link_mmio(uint32 addr);
+// ںҳ paddr ֻӳ䵽û̬ɷʵ vaddrн̹
+// Ҫڴû֮ǰ
+void link_shared(uint32 vaddr, uint32 paddr);
 void unlink_page(uint32 vaddr);
 
 void flush_tlb(uint32 vaddr);
+// ˢ count ҳ TLB_FLUSH_MAX ҳʱ cr3
+void flush_tlb_range(uint32 vaddr, uint32 count);
+
+// ˢ TLBҳϲΪ
+typedef struct tlb_batch_t {
+  uint32 start; // ʼַ
+  uint32 count; // ҳ
+  uint32 total; // Ѽҳ
+} tlb_batch_t;
+
+void tlb_batch_init(tlb_batch_t *batch);
+void tlb_batch_add(tlb_batch_t *batch, uint32 vaddr);
+void tlb_batch_flush(tlb_batch_t *batch);
 
 page_entry_t *copy_pde();
 
@@ -1,29 +1,63 @@
 #ifndef CONIX_MUTEX_H
 #define CONIX_MUTEX_H
 
+#include "kstat.h"
 #include "list.h"
-#include "task.h"
 #include "types.h"
+#include "wait.h"
 
-// 
+// ദ֮以⣬ڼ䲻
+typedef struct spinlock_t {
+  volatile uint32 locked;
+} spinlock_t;
+
+void spin_init(spinlock_t *lock);
+void spin_lock(spinlock_t *lock);
+bool spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+
+//  CPU ʱĴ
+#define MUTEX_SPIN_MAX 1000
+
+// ʱͷʱֱתĵȴ
 typedef struct mutex_t {
-  bool value;
-  list_t waiters;
+  bool volatile value;
+  struct task_t *volatile owner;
+  wait_queue_t wait; // ռȴ
+  lock_stat_t stat;
 } mutex_t;
 
 void mutex_init(mutex_t *mutex);
 void mutex_lock(mutex_t *mutex);
 void mutex_unlock(mutex_t *mutex);
 
-// 
+// ߼̳еȴߵȼ
 typedef struct lock_t {
   struct task_t *holder;
   mutex_t mutex;
   uint32 repeat;
+  list_node_t node; // ߵڵ
 } lock_t;
 
 void lock_init(lock_t *lock);
 void lock_acquire(lock_t *lock);
 void lock_release(lock_t *lock);
 
+// ¼ЧȨأȡȨغͳеϵȴȨصֵ
+void lock_reweight(struct task_t *task);
+
+// д߿ͬʱУдȣдߵȴʱµĶ
+typedef struct rwlock_t {
+  uint32 readers;        // ж
+  uint32 writers;        // ȴд
+  struct task_t *writer; // д
+  wait_queue_t wait;     // ߹ȴд߶ռȴ
+} rwlock_t;
+
+void rwlock_init(rwlock_t *rw);
+void read_lock(rwlock_t *rw);
+void read_unlock(rwlock_t *rw);
+void write_lock(rwlock_t *rw);
+void write_unlock(rwlock_t *rw);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef CONIX_SMP_H
+#define CONIX_SMP_H
+
+#include "global.h"
+#include "types.h"
+
+#define CPU_MAX 8
+
+// ӦôʵģʽҪ 1M  4K λ
+#define AP_BOOT_ADDR 0x8000
+
+// ʱС
+typedef struct runqueue_t {
+  struct task_t **heap;
+  uint32 size;
+  uint32 capacity;
+  uint32 min_vruntime; // 
+} runqueue_t;
+
+typedef struct cpu_t {
+  uint32 id;              // ߼ţΪ 0
+  uint32 apic_id;         //  APIC 
+  bool volatile started;  // Ѿ
+  bool volatile halted;   //  hlt еȴж
+  uint32 lock_depth;      // ںǶײ
+  tss_t *tss;             // ״̬Σڴû̬ں
+  struct task_t *idle;    // 
+  struct task_t *current; // е
+  runqueue_t rq;          // 
+} cpu_t;
+
+extern cpu_t cpus[CPU_MAX];
+extern uint32 cpu_count;
+extern bool smp_enabled;
+
+cpu_t *cpu_current();
+
+// ںͬһʱֻһ CPU ִں˴룬ʱΪղ
+void kernel_lock();
+void kernel_unlock();
+// ȫͷŴںǶײںȴ CPU
+uint32 kernel_unlock_all();
+void kernel_lock_all(uint32 depth);
+
+// о cpu ĶУҪʱ֪ͨе CPU 
+void cpu_kick(cpu_t *cpu);
+
+//  MP ñ task_init ֮ǰ
+void smp_init();
+// л APIC Ӧô
+void smp_boot();
+
+#endif
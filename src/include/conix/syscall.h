@@ -1,7 +1,9 @@
 #ifndef CONIX_SYSCALL_H
 #define CONIX_SYSCALL_H
 
+#include "kstat.h"
 #include "types.h"
+#include "uring.h"
 
 typedef enum syscall_t {
   SYS_NR_TEST,
@@ -19,15 +21,25 @@ typedef enum syscall_t {
   SYS_NR_TIME = 13,
   SYS_NR_LSEEK = 19,
   SYS_NR_GETPID = 20,
+  SYS_NR_NICE = 34,
   SYS_NR_MKDIR = 39,
   SYS_NR_RMDIR = 40,
   SYS_NR_BRK = 45,
   SYS_NR_UMASK = 60,
   SYS_NR_CHROOT = 61,
   SYS_NR_GETPPID = 64,
+  SYS_NR_READV = 145,
+  SYS_NR_WRITEV = 146,
   SYS_NR_YIELD = 158,
   SYS_NR_SLEEP = 162,
+  SYS_NR_PREAD = 180,
+  SYS_NR_PWRITE = 181,
   SYS_NR_GETCWD = 183,
+  SYS_NR_SENDFILE = 187,
+  SYS_NR_VFORK = 190,
+  SYS_NR_KSTAT = 200,
+  SYS_NR_URING_SETUP = 201,
+  SYS_NR_URING_ENTER = 202,
 } syscall_t;
 
 uint32 test();
@@ -37,14 +49,23 @@ void sleep(uint32 ms);
 void exit(int status);
 
 pid_t fork();
+// ӽ븸ַ̹ռ䣬ֻܵ exit ˳
+pid_t vfork();
 pid_t getpid();
 pid_t getppid();
 pid_t waitpid(pid_t pid, int32 *status);
+//  nice ֵµ nice ֵ
+int nice(int increment);
 
 int32 brk(void *addr);
+// Ѷ increment ֽڣԭĶѶ
+void *sbrk(int32 increment);
 
 time_t time();
 
+// ȡںͳϢ
+int kstat(kstat_type_t type, void *buf);
+
 int mkdir(char *pathname, int mode);
 int rmdir(char *pathname);
 
@@ -54,6 +75,20 @@ void close(fd_t fd);
 int32 read(fd_t fd, char *buf, int len);
 int32 write(fd_t fd, char *buf, int len);
 int lseek(fd_t fd, off_t offset, int whence);
+// ɢд count λ壬һϵͳ
+int32 readv(fd_t fd, iovec_t *iov, int count);
+int32 writev(fd_t fd, iovec_t *iov, int count);
+//  offset дıļƫ
+int32 pread(fd_t fd, char *buf, int len, off_t offset);
+int32 pwrite(fd_t fd, char *buf, int len, off_t offset);
+// ںа in  count ֽڸƵ outû
+int32 sendfile(fd_t out, fd_t in, off_t *offset, int count);
+
+// ע첽󻷣֮дύƽ sq_tail
+//  uring_enter ֪ͨںˣɶո
+int uring_setup(uring_t *ring);
+// ȴ min_complete ؿո
+int uring_enter(uint32 min_complete);
 
 mode_t umask(mode_t mask);
 // Ӳ
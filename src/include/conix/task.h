@@ -1,8 +1,11 @@
 #ifndef CONIX_TASK_H
 #define CONIX_TASK_H
 
+#include "bitmap.h"
 #include "fs.h"
+#include "kstat.h"
 #include "list.h"
+#include "timer.h"
 #include "types.h"
 
 #define KERNEL_USER 0
@@ -10,7 +13,11 @@
 
 #define TASK_NAME_LEN 16
 
-#define TASK_FILE_NR 16
+#define TASK_FILE_NR 16    // ļĳʼС
+#define TASK_FILE_MAX 1024 // ļС
+
+#define NICE_MIN -20
+#define NICE_MAX 19
 
 // 庯ָ
 typedef void (*target_t)();
@@ -25,29 +32,51 @@ typedef enum task_state_t {
   TASK_DIED,
 } task_state_t;
 
+// ļʱӱ
+typedef struct fd_table_t {
+  struct file_t **files;
+  bitmap_t map; // ʹõ0 1 2 ̶Ϊ׼
+  uint32 size;  // ĸ
+  fd_t next;    // С next ʹ
+} fd_table_t;
+
 // PCB
 typedef struct task_t {
   uint32 *stack;    // ںջ
   list_node_t node; // ڵ
   task_state_t state;
   uint32 priority;
-  uint32 ticks;   // ʣʱƬ
-  uint32 jiffies; // ϴִʱȫʱƬ
+  uint32 ticks;    // ʣʱƬ
+  uint32 jiffies;  // ϴִʱȫʱƬ
+  uint32 ready;    // еʱ
+  uint32 vruntime; // Ȩʱ
+  uint32 weight;   // Ȩأ nice 
+  int nice;
+  struct cpu_t *cpu;        //  CPUʱĶ
+  struct lock_t *blocked_on; // ڵȴ
+  list_t locks;              // еȼ̳
   char name[TASK_NAME_LEN];
   uint32 uid;
   uint32 gid;
   pid_t pid;
   pid_t ppid;
+  list_node_t hnode;   // pid ϣڵ
+  list_t children;     // ӽ
+  list_node_t sibling; // ӽеĽڵ
   int status;
   pid_t waitpid; // ̵ȴյpid
   char *pwd;
   uint32 pde;
   struct bitmap_t *vmap; // ڴλͼ
   uint32 brk;            // ̶ڴߵַ
+  fault_stat_t fault;    // ȱҳͳ
+  timer_t timer;         // ˯߶ʱ
   struct inode_t *ipwd;
   struct inode_t *iroot;
   uint16 umask;
-  struct file_t *files[TASK_FILE_NR];
+  fd_table_t fdt;
+  struct uring_ctx_t *uring; // 첽
+  bool vfork;   // 븸ַ̹ռ䣬ֱ̹ӽ˳
   uint32 magic; // ںħڼջ
 } task_t;
 
@@ -88,6 +117,12 @@ typedef struct intr_frame_t {
 
 task_t *running_task();
 void schedule();
+// ʱжиµǰʱ
+void task_tick();
+// Ⱥͳʹõ TSC ʱӣ֧ʱΪ 0
+uint32 sched_clock();
+// nice ӦȨأ̳еĲ
+uint32 task_base_weight(task_t *task);
 
 void task_exit(int status);
 void task_yield();
@@ -95,17 +130,23 @@ void task_block(task_t *task, list_t *blist, task_state_t state);
 void task_unblock(task_t *task);
 
 void task_sleep(uint32 ms);
-void task_wakeup();
+// ǰûҪ
+bool task_idle();
 
 void task_to_user_mode(target_t target);
 
 pid_t task_fork();
+pid_t task_vfork();
 
 pid_t sys_getpid();
 pid_t sys_getppid();
+int sys_nice(int increment);
 pid_t task_waitpid(pid_t pid, int *status);
 
-fd_t task_get_fd(task_t *task);
+// СĿָ fileѴʱ EOF
+fd_t task_get_fd(task_t *task, struct file_t *file);
 void task_put_fd(task_t *task, fd_t fd);
+// Ӧļûдʱ NULL
+struct file_t *task_file(task_t *task, fd_t fd);
 
 #endif
\ No newline at end of file
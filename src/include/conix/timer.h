@@ -0,0 +1,31 @@
+#ifndef CONIX_TIMER_H
+#define CONIX_TIMER_H
+
+#include "list.h"
+#include "types.h"
+
+typedef void (*timer_handler_t)(void *data);
+
+// ʱʱ䵥λΪ
+typedef struct timer_t {
+  list_node_t node;
+  uint32 expires; // ʱ
+  timer_handler_t handler;
+  void *data;
+} timer_t;
+
+#define time_before(a, b) ((int32)((a) - (b)) < 0)
+
+void timer_init();
+
+// ms ʱже handler(data)
+void timer_add(timer_t *timer, uint32 ms, timer_handler_t handler, void *data);
+void timer_del(timer_t *timer);
+
+// ִ now ֮ǰڵĶʱ
+void timer_expire(uint32 now);
+
+// һʱ now ĺ max
+uint32 timer_next(uint32 now, uint32 max);
+
+#endif
@@ -44,4 +44,10 @@ typedef enum std_fd_t {
 
 typedef int32 off_t;
 
+// ɢдһλ
+typedef struct iovec_t {
+  void *base;
+  size_t len;
+} iovec_t;
+
 #endif
\ No newline at end of file
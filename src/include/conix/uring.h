@@ -0,0 +1,51 @@
+#ifndef CONIX_URING_H
+#define CONIX_URING_H
+
+#include "types.h"
+
+// ύкɶе 2 
+#define URING_ENTRIES 32
+
+// ύ offset Ϊֵʱʹòƽļƫ
+#define URING_OFFSET_CUR -1
+
+typedef enum uring_op_t {
+  URING_NOP,
+  URING_READ,
+  URING_WRITE,
+  URING_OPEN,
+  URING_CLOSE,
+  URING_FSYNC,
+} uring_op_t;
+
+// ύûд
+typedef struct uring_sqe_t {
+  uint32 opcode;
+  fd_t fd;
+  void *buf;    // д壬ʱΪ·
+  uint32 len;   // дֽ
+  off_t offset; // дλ
+  int flags;    // 򿪱־
+  int mode;     // ģʽ
+  uint32 data;  // ԭ
+} uring_sqe_t;
+
+// ںд
+typedef struct uring_cqe_t {
+  uint32 data;
+  int32 result; // Ӧϵͳõķֵ
+} uring_cqe_t;
+
+// ûռ䣬ûں˹
+// ûƽ sq_tail  cq_headںƽ sq_head  cq_tail
+// ±ֻȡģõλ
+typedef struct uring_t {
+  uint32 volatile sq_head;
+  uint32 volatile sq_tail;
+  uint32 volatile cq_head;
+  uint32 volatile cq_tail;
+  uring_sqe_t sqes[URING_ENTRIES];
+  uring_cqe_t cqes[URING_ENTRIES];
+} uring_t;
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef CONIX_VDSO_H
+#define CONIX_VDSO_H
+
+#include "memory.h"
+#include "types.h"
+
+// ûջ֮ϵһҳֻӳ䵽н
+#define VDSO_ADDR USER_STACK_TOP
+
+// ϵͳڣeax Ϊúţebx ecx edx Ϊֵ eax
+// ֧ʱʹ sysenterʹ int 0x80
+#define VDSO_SYSCALL VDSO_ADDR
+
+// ֮һҳںάݣûֻ
+#define VDSO_DATA_ADDR (VDSO_ADDR + PAGE_SIZE)
+
+// ȶ seqΪ seq ı¶ȡ
+typedef struct vdso_data_t {
+  uint32 seq;          // ˳ʾںڸ
+  uint32 jiffies;      // ʱƬ
+  uint32 jiffy;        // ÿʱƬĺ
+  time_t startup_time; // ʱ
+  bool pid_valid;      // ദʱ CPU еĽ̲ͬ
+  pid_t pid;           // еĽ
+  pid_t ppid;
+} vdso_data_t;
+
+// Ƿʹ sysenter ں
+extern bool sysenter_enabled;
+
+void vdso_init();
+// ʱƬǰҳ
+void vdso_update_time();
+// лʱǰ̵ pid
+void vdso_update_pid(pid_t pid, pid_t ppid);
+// õǰ sysenter MSRÿһ
+void sysenter_init();
+
+#endif
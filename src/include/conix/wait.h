@@ -0,0 +1,44 @@
+#ifndef CONIX_WAIT_H
+#define CONIX_WAIT_H
+
+#include "list.h"
+#include "types.h"
+
+// ȴУĵȴÿȫѣռĵȴ߰Ⱥÿλһ
+typedef struct wait_queue_t {
+  list_t shared;
+  list_t exclusive;
+} wait_queue_t;
+
+void wait_queue_init(wait_queue_t *wq);
+
+// ǰֱѣҪж
+void wait_sleep(wait_queue_t *wq, bool exclusive);
+
+// йĵȴߺ nr ռĵȴߣػѵ
+uint32 wait_wakeup(wait_queue_t *wq, uint32 nr);
+
+// Ķռȴֱ߲תԴûеȴ߷ NULL
+struct task_t *wait_handoff(wait_queue_t *wq);
+
+#define wake_up(wq) wait_wakeup(wq, 1)
+#define wake_up_all(wq) wait_wakeup(wq, -1)
+
+bool wait_active(wait_queue_t *wq);
+
+// ʱѺ¼飬ٻ
+#define wait_event(wq, cond)                                                   \
+  do {                                                                         \
+    while (!(cond)) {                                                          \
+      wait_sleep(wq, false);                                                   \
+    }                                                                          \
+  } while (0)
+
+#define wait_event_exclusive(wq, cond)                                         \
+  do {                                                                         \
+    while (!(cond)) {                                                          \
+      wait_sleep(wq, true);                                                    \
+    }                                                                          \
+  } while (0)
+
+#endif
@@ -0,0 +1,155 @@
+#include "../include/conix/apic.h"
+#include "../include/conix/assert.h"
+#include "../include/conix/interrupt.h"
+#include "../include/conix/io.h"
+
+//  APIC Ĵ
+#define LAPIC_ID 0x20
+#define LAPIC_TPR 0x80
+#define LAPIC_EOI 0xB0
+#define LAPIC_SVR 0xF0
+#define LAPIC_ESR 0x280
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_TIMER_INIT 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIV 0x3E0
+
+#define LAPIC_SVR_ENABLE (1 << 8)
+#define LAPIC_LVT_MASKED (1 << 16)
+#define LAPIC_TIMER_PERIODIC (1 << 17)
+#define LAPIC_TIMER_DIV16 0b0011
+
+#define ICR_INIT 0x500
+#define ICR_STARTUP 0x600
+#define ICR_PENDING (1 << 12)
+#define ICR_ASSERT (1 << 14)
+
+// IOAPIC ͨѡĴʹڼĴӷ
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+#define IOAPIC_REDTBL 0x10 // ضÿĴ
+#define IOAPIC_MASKED (1 << 16)
+
+#define PIC_M_DATA 0x21
+#define PIC_S_DATA 0xa1
+
+#define IRQ_NR 16
+
+extern uint32 jiffy;
+extern void clock_delay(uint32 us);
+
+bool apic_enabled = false;
+
+static uint32 ioapic_base;
+static uint32 ioapic_pins[IRQ_NR]; // ж϶Ӧ IOAPIC 
+static uint32 lapic_ticks;         // ÿ jiffy ıʱӼ
+
+static uint32 lapic_read(uint32 reg) {
+  return *(volatile uint32 *)(LAPIC_BASE + reg);
+}
+
+static void lapic_write(uint32 reg, uint32 value) {
+  *(volatile uint32 *)(LAPIC_BASE + reg) = value;
+}
+
+static uint32 ioapic_read(uint32 reg) {
+  *(volatile uint32 *)(ioapic_base + IOAPIC_REGSEL) = reg;
+  return *(volatile uint32 *)(ioapic_base + IOAPIC_WINDOW);
+}
+
+static void ioapic_write(uint32 reg, uint32 value) {
+  *(volatile uint32 *)(ioapic_base + IOAPIC_REGSEL) = reg;
+  *(volatile uint32 *)(ioapic_base + IOAPIC_WINDOW) = value;
+}
+
+void lapic_init() {
+  lapic_write(LAPIC_TPR, 0); // ȼж
+  lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS);
+  // ״̬Ҫд
+  lapic_write(LAPIC_ESR, 0);
+  lapic_write(LAPIC_ESR, 0);
+}
+
+uint32 lapic_id() { return lapic_read(LAPIC_ID) >> 24; }
+
+void lapic_eoi() { lapic_write(LAPIC_EOI, 0); }
+
+void lapic_timer_calibrate() {
+  lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV16);
+  lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+  lapic_write(LAPIC_TIMER_INIT, 0xffffffff);
+
+  clock_delay(jiffy * 1000);
+
+  lapic_ticks = 0xffffffff - lapic_read(LAPIC_TIMER_CURRENT);
+  lapic_write(LAPIC_TIMER_INIT, 0);
+}
+
+void lapic_timer_init() {
+  assert(lapic_ticks > 0);
+  lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV16);
+  lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+  lapic_write(LAPIC_TIMER_INIT, lapic_ticks);
+}
+
+static void lapic_icr(uint32 apic_id, uint32 command) {
+  lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+  lapic_write(LAPIC_ICR_LOW, command);
+  while (lapic_read(LAPIC_ICR_LOW) & ICR_PENDING)
+    ;
+}
+
+void lapic_send_ipi(uint32 apic_id, uint32 vector) {
+  lapic_icr(apic_id, ICR_ASSERT | vector);
+}
+
+void lapic_startup(uint32 apic_id, uint32 addr) {
+  assert((addr & 0xfff) == 0 && addr < 0x100000);
+
+  lapic_icr(apic_id, ICR_INIT | ICR_ASSERT);
+  clock_delay(10000);
+
+  //  MP 淶 STARTUP
+  for (size_t i = 0; i < 2; ++i) {
+    lapic_icr(apic_id, ICR_STARTUP | (addr >> 12));
+    clock_delay(200);
+  }
+}
+
+void ioapic_init(uint32 addr) { ioapic_base = addr; }
+
+void ioapic_route(uint32 irq, uint32 pin, uint32 flags, uint32 apic_id) {
+  assert(irq < IRQ_NR);
+  ioapic_pins[irq] = pin;
+  ioapic_write(IOAPIC_REDTBL + pin * 2 + 1, apic_id << 24);
+  ioapic_write(IOAPIC_REDTBL + pin * 2,
+               IOAPIC_MASKED | flags | (IRQ_MASTER_NR + irq));
+}
+
+void ioapic_mask(uint32 irq, bool enable) {
+  assert(irq < IRQ_NR);
+  uint32 reg = IOAPIC_REDTBL + ioapic_pins[irq] * 2;
+  uint32 value = ioapic_read(reg);
+  if (enable) {
+    value &= ~IOAPIC_MASKED;
+  } else {
+    value |= IOAPIC_MASKED;
+  }
+  ioapic_write(reg, value);
+}
+
+void apic_enable() {
+  // 8259 Ѿ򿪵жϸ IOAPIC 
+  uint32 mask = (inb(PIC_M_DATA) & 0xff) | (inb(PIC_S_DATA) & 0xff) << 8;
+  outb(PIC_M_DATA, 0xff);
+  outb(PIC_S_DATA, 0xff);
+
+  apic_enabled = true;
+  for (size_t irq = 0; irq < IRQ_NR; ++irq) {
+    if (irq != IRQ_CASCADE && !(mask & (1 << irq))) {
+      ioapic_mask(irq, true);
+    }
+  }
+}
@@ -2,6 +2,7 @@
 #include "../include/conix/assert.h"
 #include "../include/conix/device.h"
 #include "../include/conix/memory.h"
+#include "../include/conix/wait.h"
 
 #define HASH_COUNT 31
 
@@ -15,7 +16,7 @@ static void *buffer_data =
     (void *)(KERNEL_BUFFER_MEM + KERNEL_BUFFER_SIZE - BLOCK_SIZE);
 
 static list_t free_list;              // 
-static list_t wait_list;              // ȴ
+static wait_queue_t buffer_wait;      // ȴлĽ
 static list_t hash_table[HASH_COUNT]; // ϣ
 
 uint32 hash(dev_t dev, idx_t block) { return (dev ^ block) % HASH_COUNT; }
@@ -98,7 +99,7 @@ static buffer_t *get_free_buffer() {
       return bf;
     }
 
-    task_block(running_task(), &wait_list, TASK_BLOCKED);
+    wait_sleep(&buffer_wait, true);
   }
 }
 
@@ -169,16 +170,15 @@ void brelse(buffer_t *bf) {
     bwrite(bf); // дǿһ
   }
 
-  // еȴʹûḶ̌
-  if (!list_empty(&wait_list)) {
-    task_t *task = element_entry(task_t, node, list_popback(&wait_list));
-    task_unblock(task);
+  // лʱŻһȴĽ
+  if (bf->count == 0) {
+    wake_up(&buffer_wait);
   }
 }
 
 void buffer_init() {
   list_init(&free_list);
-  list_init(&wait_list);
+  wait_queue_init(&buffer_wait);
 
   for (size_t i = 0; i < HASH_COUNT; ++i) {
     list_init(&hash_table[i]);
@@ -3,7 +3,11 @@
 #include "../include/conix/debug.h"
 #include "../include/conix/interrupt.h"
 #include "../include/conix/io.h"
+#include "../include/conix/kstat.h"
+#include "../include/conix/stdlib.h"
 #include "../include/conix/task.h"
+#include "../include/conix/timer.h"
+#include "../include/conix/vdso.h"
 
 #define PIT_CHAN0_REG 0X40
 #define PIT_CHAN2_REG 0X42
@@ -11,9 +15,12 @@
 
 #define HZ 100
 #define OSCILLATOR 1193182
-#define CLOCK_COUNTER (OSCILLATOR / HZ)
 #define JIFFY (1000 / HZ)
 
+//  0 ڵģʽÿΰһʱ±
+#define CYCLES_PER_MS (OSCILLATOR / 1000)
+#define CLOCK_MAX_MS (0xffff / CYCLES_PER_MS)
+
 #define SPEAKER_REG 0x61
 #define BEEP_HZ 440
 #define BEEP_COUNTER (OSCILLATOR / BEEP_HZ)
@@ -22,6 +29,13 @@
 uint32 volatile jiffies = 0;
 uint32 jiffy = JIFFY;
 
+uint32 volatile clock_ms = 0; // ĺ
+
+static uint32 clock_cycles;   // һ
+static uint32 clock_count;    // α̵ļֵ
+static uint32 clock_deadline; // α̵ĵʱ
+static uint32 next_tick;      // һεʱӵʱ
+
 uint32 volatile beeping = 0;
 
 void start_beep() {
@@ -38,24 +52,131 @@ void stop_beep() {
   }
 }
 
+// ʱǰ cycles 
+static void clock_advance(uint32 cycles) {
+  uint32 seconds = jiffies / HZ;
+
+  clock_cycles += cycles;
+  clock_ms += clock_cycles / CYCLES_PER_MS;
+  clock_cycles %= CYCLES_PER_MS;
+
+  uint32 last = jiffies;
+  jiffies = clock_ms / JIFFY;
+  if (jiffies != last) {
+    vdso_update_time();
+  }
+  if (jiffies / HZ != seconds) {
+    kstat_tick();
+  }
+}
+
+// ms һʱж
+static void clock_program(uint32 ms) {
+  ms = MAX(ms, 1);
+  ms = MIN(ms, CLOCK_MAX_MS);
+
+  clock_count = ms * CYCLES_PER_MS;
+  clock_deadline = clock_ms + ms;
+
+  outb(PIT_CTRL_REG, 0b00110000);
+  outb(PIT_CHAN0_REG, clock_count & 0xff);
+  outb(PIT_CHAN0_REG, (clock_count >> 8) & 0xff);
+}
+
+// ʱֻڶʱʱжϣÿ jiffy жһ
+static void clock_program_next() {
+  uint32 ms = timer_next(clock_ms, CLOCK_MAX_MS);
+  if (!task_idle()) {
+    uint32 tick = time_before(clock_ms, next_tick) ? next_tick - clock_ms : 0;
+    ms = MIN(ms, tick);
+  }
+  clock_program(ms);
+}
+
+// ȡ 0 ʣѾڷ false
+static bool clock_latch(uint32 *count) {
+  outb(PIT_CTRL_REG, 0b11000010); //  0 ״̬ͼ
+  uint8 status = inb(PIT_CHAN0_REG);
+  *count = inb(PIT_CHAN0_REG) & 0xff;
+  *count |= (inb(PIT_CHAN0_REG) & 0xff) << 8;
+
+  // ֵûװ
+  if (status & 0x40) {
+    *count = clock_count;
+  }
+  return !(status & 0x80) && *count <= clock_count;
+}
+
+// ǰʱ̣αʱ
+uint32 clock_now() {
+  uint32 count;
+  if (!clock_latch(&count)) {
+    return clock_deadline;
+  }
+  return clock_ms + (clock_cycles + clock_count - count) / CYCLES_PER_MS;
+}
+
+// µĶʱ PIT ĵʱ̣±
+void clock_reschedule(uint32 expires) {
+  if (!time_before(expires, clock_deadline)) {
+    return;
+  }
+
+  uint32 count;
+  if (!clock_latch(&count)) {
+    return; // ʱжϾͻᴦ
+  }
+  clock_advance(clock_count - count);
+  clock_program_next();
+}
+
 void clock_handler(int vec) {
   assert(vec == 0x20);
   send_eoi(vec);
 
-  jiffies++;
+  clock_advance(clock_count);
+  timer_expire(clock_ms);
 
-  task_wakeup();
+  bool tick = !time_before(clock_ms, next_tick);
+  if (tick) {
+    next_tick = clock_ms + JIFFY;
+  }
+  clock_program_next();
 
-  task_t *task = running_task();
-  assert(task->magic == CONIX_MAGIC);
+  if (tick) {
+    task_tick();
+  }
+}
 
-  task->jiffies = jiffies;
-  task->ticks--;
+// ü 2 
+static void beep_init() {
+  outb(PIT_CTRL_REG, 0b10110110);
+  outb(PIT_CHAN2_REG, (uint8)BEEP_COUNTER);
+  outb(PIT_CHAN2_REG, (uint8)(BEEP_COUNTER >> 8));
+}
 
-  if (!task->ticks) {
-    task->ticks = task->priority;
-    schedule();
+// ü 2 æ us ΢룬Ӧôʱʹãָ
+void clock_delay(uint32 us) {
+  uint8 speaker = inb(SPEAKER_REG);
+  while (us) {
+    uint32 part = MIN(us, CLOCK_MAX_MS * 1000);
+    uint32 count = part * CYCLES_PER_MS / 1000;
+    count = MAX(count, 1);
+
+    // رͼ 2 ţװſʼ
+    outb(SPEAKER_REG, speaker & 0xfc);
+    outb(PIT_CTRL_REG, 0b10110000);
+    outb(PIT_CHAN2_REG, count & 0xff);
+    outb(PIT_CHAN2_REG, (count >> 8) & 0xff);
+    outb(SPEAKER_REG, (speaker & 0xfc) | 1);
+
+    //  0 Ϊߵƽ
+    while (!(inb(SPEAKER_REG) & 0x20))
+      ;
+    us -= part;
   }
+  beep_init();
+  outb(SPEAKER_REG, speaker);
 }
 
 extern uint32 startup_time;
@@ -63,17 +184,14 @@ time_t sys_time() { return startup_time + (jiffies * JIFFY) / 1000; }
 
 void pit_init() {
   // ü 0 ʱ
-  outb(PIT_CTRL_REG, 0b00110100);
-  outb(PIT_CHAN0_REG, CLOCK_COUNTER & 0xff);
-  outb(PIT_CHAN0_REG, (CLOCK_COUNTER >> 8) & 0xff);
+  next_tick = JIFFY;
+  clock_program(JIFFY);
 
-  // ü 2 
-  outb(PIT_CTRL_REG, 0b10110110);
-  outb(PIT_CHAN2_REG, (uint8)BEEP_COUNTER);
-  outb(PIT_CHAN2_REG, (uint8)(BEEP_COUNTER >> 8));
+  beep_init();
 }
 
 void clock_init() {
+  timer_init();
   pit_init();
   set_interrupt_handler(IRQ_CLOCK, clock_handler);
   set_interrupt_mask(IRQ_CLOCK, true);
@@ -0,0 +1,56 @@
+#include "../include/conix/cpu.h"
+
+bool cpuid_support() {
+  // ޸ eflags  ID λ֧ cpuid
+  asm volatile("pushfl\n"
+               "pushfl\n"
+               "xorl $0x200000, (%esp)\n"
+               "popfl\n"
+               "pushfl\n"
+               "popl %eax\n"
+               "xorl (%esp), %eax\n"
+               "popfl\n"
+               "shrl $21, %eax\n"
+               "andl $1, %eax\n");
+}
+
+void cpuid(uint32 leaf, uint32 *eax, uint32 *ebx, uint32 *ecx, uint32 *edx) {
+  asm volatile("cpuid\n"
+               : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+               : "a"(leaf), "c"(0));
+}
+
+bool cpu_has(uint32 feature) {
+  if (!cpuid_support()) {
+    return false;
+  }
+
+  uint32 eax, ebx, ecx, edx;
+  cpuid(0, &eax, &ebx, &ecx, &edx);
+  if (eax < 1) {
+    return false;
+  }
+
+  cpuid(1, &eax, &ebx, &ecx, &edx);
+  return (edx & feature) == feature;
+}
+
+uint64 rdtsc() { asm volatile("rdtsc\n"); }
+
+uint32 xchg(volatile uint32 *addr, uint32 value) {
+  asm volatile("xchgl %0, %1\n" : "+m"(*addr), "+r"(value) : : "memory");
+  return value;
+}
+
+void cpu_relax() { asm volatile("pause\n"); }
+
+uint64 rdmsr(uint32 msr) { asm volatile("rdmsr\n" ::"c"(msr)); }
+
+void wrmsr(uint32 msr, uint64 value) {
+  asm volatile("wrmsr\n" ::"c"(msr), "a"((uint32)value),
+               "d"((uint32)(value >> 32)));
+}
+
+uint32 get_cr4() { asm volatile("movl %cr4, %eax\n"); }
+
+void set_cr4(uint32 cr4) { asm volatile("movl %%eax, %%cr4\n" ::"a"(cr4)); }
@@ -44,9 +44,17 @@ extern void sys_close();
 extern int32 sys_read();
 extern int32 sys_write();
 extern int32 sys_lseek();
+extern int32 sys_readv();
+extern int32 sys_writev();
+extern int32 sys_pread();
+extern int32 sys_pwrite();
+extern int32 sys_sendfile();
+extern int sys_uring_setup();
+extern int sys_uring_enter();
 extern int sys_chdir();
 extern int sys_chroot();
 extern char *sys_getcwd();
+extern int sys_kstat();
 
 void syscall_init() {
   for (size_t i = 0; i < SYSCALL_SIZE; ++i) {
@@ -59,9 +67,11 @@ void syscall_init() {
 
   syscall_table[SYS_NR_EXIT] = task_exit;
   syscall_table[SYS_NR_FORK] = task_fork;
+  syscall_table[SYS_NR_VFORK] = task_vfork;
   syscall_table[SYS_NR_GETPID] = sys_getpid;
   syscall_table[SYS_NR_GETPPID] = sys_getppid;
   syscall_table[SYS_NR_WAITPID] = task_waitpid;
+  syscall_table[SYS_NR_NICE] = sys_nice;
 
   syscall_table[SYS_NR_BRK] = sys_brk;
   syscall_table[SYS_NR_TIME] = sys_time;
@@ -72,6 +82,13 @@ void syscall_init() {
   syscall_table[SYS_NR_READ] = sys_read;
   syscall_table[SYS_NR_WRITE] = sys_write;
   syscall_table[SYS_NR_LSEEK] = sys_lseek;
+  syscall_table[SYS_NR_READV] = sys_readv;
+  syscall_table[SYS_NR_WRITEV] = sys_writev;
+  syscall_table[SYS_NR_PREAD] = sys_pread;
+  syscall_table[SYS_NR_PWRITE] = sys_pwrite;
+  syscall_table[SYS_NR_SENDFILE] = sys_sendfile;
+  syscall_table[SYS_NR_URING_SETUP] = sys_uring_setup;
+  syscall_table[SYS_NR_URING_ENTER] = sys_uring_enter;
 
   syscall_table[SYS_NR_MKDIR] = sys_mkdir;
   syscall_table[SYS_NR_RMDIR] = sys_rmdir;
@@ -82,4 +99,6 @@ void syscall_init() {
   syscall_table[SYS_NR_CHDIR] = sys_chdir;
   syscall_table[SYS_NR_CHROOT] = sys_chroot;
   syscall_table[SYS_NR_GETCWD] = sys_getcwd;
+
+  syscall_table[SYS_NR_KSTAT] = sys_kstat;
 }
@@ -68,14 +68,14 @@ void gdt_init() {
   // asm volatile("lgdt gdt_ptr");
 }
 
-void tss_init() {
-  memset(&tss, 0, sizeof(tss));
+void tss_load(tss_t *tss, uint32 idx) {
+  memset(tss, 0, sizeof(tss_t));
 
-  tss.ss0 = KERNEL_DATA_SELECTOR;
-  tss.iobase = sizeof(tss);
+  tss->ss0 = KERNEL_DATA_SELECTOR;
+  tss->iobase = sizeof(tss_t);
 
-  descriptor_t *desc = gdt + KERNEL_TSS_IDX;
-  descriptor_init(desc, (uint32)&tss, sizeof(tss) - 1);
+  descriptor_t *desc = gdt + idx;
+  descriptor_init(desc, (uint32)tss, sizeof(tss_t) - 1);
   desc->segment = 0;     // ϵͳ
   desc->granularity = 0; // ֽ
   desc->big = 0;         // ̶Ϊ 0
@@ -84,5 +84,7 @@ void tss_init() {
   desc->DPL = 0;         // Ż
   desc->type = 0b1001;   // 32 λ tss
 
-  asm volatile("ltr %%ax\n" ::"a"(KERNEL_TSS_SELECTOR));
+  asm volatile("ltr %%ax\n" ::"a"(idx << 3));
 }
+
+void tss_init() { tss_load(&tss, KERNEL_TSS_IDX); }
@@ -5,6 +5,8 @@
 section .text
 
 extern handler_table
+extern kernel_lock
+extern kernel_unlock
 
 %macro INTERRUPT_HANDLER 2
 interrupt_handler_%1
@@ -25,6 +27,9 @@ interrupt_entry:
     push gs
     pusha ; ͨüĴ general reg
 
+    ; ں
+    call kernel_lock
+
     mov eax, [esp + 12 * 4]
 
     ; arg for handler
@@ -38,6 +43,9 @@ interrupt_exit:
     ; ָջ
     add esp, 4
 
+    ; 뿪ںˣeax ecx edx  popa ָ
+    call kernel_unlock
+
     popa
     pop gs 
     pop fs
@@ -104,6 +112,23 @@ INTERRUPT_HANDLER 0x2d, 0
 INTERRUPT_HANDLER 0x2e, 0; harddisk1(main)
 INTERRUPT_HANDLER 0x2f, 0; harddisk2 
 
+INTERRUPT_HANDLER 0x30, 0; local apic timer
+INTERRUPT_HANDLER 0x31, 0; reschedule ipi
+INTERRUPT_HANDLER 0x32, 0
+INTERRUPT_HANDLER 0x33, 0
+INTERRUPT_HANDLER 0x34, 0
+INTERRUPT_HANDLER 0x35, 0
+INTERRUPT_HANDLER 0x36, 0
+INTERRUPT_HANDLER 0x37, 0
+INTERRUPT_HANDLER 0x38, 0
+INTERRUPT_HANDLER 0x39, 0
+INTERRUPT_HANDLER 0x3a, 0
+INTERRUPT_HANDLER 0x3b, 0
+INTERRUPT_HANDLER 0x3c, 0
+INTERRUPT_HANDLER 0x3d, 0
+INTERRUPT_HANDLER 0x3e, 0
+INTERRUPT_HANDLER 0x3f, 0; local apic spurious
+
 section .data
 global handler_entry_table
 handler_entry_table:
@@ -155,6 +180,22 @@ handler_entry_table:
     dd interrupt_handler_0x2d
     dd interrupt_handler_0x2e
     dd interrupt_handler_0x2f
+    dd interrupt_handler_0x30
+    dd interrupt_handler_0x31
+    dd interrupt_handler_0x32
+    dd interrupt_handler_0x33
+    dd interrupt_handler_0x34
+    dd interrupt_handler_0x35
+    dd interrupt_handler_0x36
+    dd interrupt_handler_0x37
+    dd interrupt_handler_0x38
+    dd interrupt_handler_0x39
+    dd interrupt_handler_0x3a
+    dd interrupt_handler_0x3b
+    dd interrupt_handler_0x3c
+    dd interrupt_handler_0x3d
+    dd interrupt_handler_0x3e
+    dd interrupt_handler_0x3f
 
 
 
@@ -182,17 +223,102 @@ syscall_handler:
     push gs
     pusha
 
+    ; ںˣȡǵĲ
+    call kernel_lock
+    mov eax, [esp + 7 * 4]
+    mov ecx, [esp + 6 * 4]
+    mov edx, [esp + 5 * 4]
+
     push 0x80
 
+    push esi
     push edx
     push ecx
     push ebx
 
     call [syscall_table + eax * 4]
 
-    add esp, 12
+    add esp, 16
 
     mov dword [esp + 8 * 4], eax
 
     jmp interrupt_exit
 
+
+extern sysenter_return
+
+user_code_selector equ (3 << 3 | 3)
+user_data_selector equ (4 << 3 | 3)
+
+; sysenter ʱ esp ָ tss е esp0ûջָ ebp У
+;  int 0x80 ͬж֡fork ӽ̿Դ interrupt_exit 
+global sysenter_handler
+sysenter_handler:
+    mov esp, [esp] ; ǰںջ
+
+    push user_data_selector ; ss
+    push ebp ; esp
+    pushf
+    or dword [esp], 0x200 ; sysenter رжϣû̬ʱ
+    push user_code_selector ; cs
+    push dword [sysenter_return] ; eip
+
+    ; ֤ϵͳú
+    push eax
+    call syscall_check
+    add esp, 4
+
+    push 0x20222202
+
+    push 0x80
+
+    ; ļĴϢ
+    push ds
+    push es
+    push fs
+    push gs
+    pusha
+
+    ; ںˣȡǵĲ
+    call kernel_lock
+    mov eax, [esp + 7 * 4]
+    mov ecx, [esp + 6 * 4]
+    mov edx, [esp + 5 * 4]
+
+    push 0x80
+
+    push esi
+    push edx
+    push ecx
+    push ebx
+
+    call [syscall_table + eax * 4]
+
+    add esp, 16
+
+    mov dword [esp + 8 * 4], eax
+
+    ; ָջ
+    add esp, 4
+
+    ; 뿪ں
+    call kernel_unlock
+
+    popa
+    pop gs
+    pop fs
+    pop es
+    pop ds
+
+    add esp, 8
+
+    ; ջΪ eip cs eflags esp sssysexit ص edx  ecx
+    mov edx, [esp]
+    mov ecx, [esp + 3 * 4]
+
+    ; ָ־λж sysexit ֮Ŵ
+    and dword [esp + 2 * 4], ~0x200
+    push dword [esp + 2 * 4]
+    popf
+    sti
+    sysexit
@@ -171,6 +171,7 @@ static void ide_ctrl_init() {
     ide_ctrl_t *ctrl = &controllers[cidx];
     sprintf(ctrl->name, "ide%u", cidx);
     lock_init(&ctrl->lock);
+    wait_queue_init(&ctrl->wait);
     ctrl->active = NULL;
 
     if (cidx) {
@@ -277,10 +278,8 @@ int ide_pio_read(ide_disk_t *disk, void *buf, uint8 count, idx_t lba) {
   outb(ctrl->iobase + IDE_COMMAND, IDE_CMD_READ);
 
   for (size_t i = 0; i < count; ++i) {
-    task_t *task = running_task();
-    if (task->state == TASK_RUNNING) {
-      ctrl->waiter = task;
-      task_block(task, NULL, TASK_BLOCKED);
+    if (running_task()->state == TASK_RUNNING) {
+      wait_sleep(&ctrl->wait, true);
     }
 
     ide_busy_wait(ctrl, IDE_SR_DRQ);
@@ -327,10 +326,8 @@ int ide_pio_write(ide_disk_t *disk, void *buf, uint8 count, idx_t lba) {
     uint32 offset = ((uint32)buf + i * SECTOR_SIZE);
     ide_pio_write_sector(disk, (uint16 *)offset);
 
-    task_t *task = running_task();
-    if (task->state == TASK_RUNNING) {
-      ctrl->waiter = task;
-      task_block(task, NULL, TASK_BLOCKED);
+    if (running_task()->state == TASK_RUNNING) {
+      wait_sleep(&ctrl->wait, true);
     }
 
     ide_busy_wait(ctrl, IDE_SR_NULL);
@@ -345,10 +342,7 @@ void ide_handler(int vec) {
   ide_ctrl_t *ctrl = &controllers[vec - IRQ_HARDDISK - 0x20];
 
   uint8 state = inb(ctrl->iobase + IDE_STATUS);
-  if (ctrl->waiter) {
-    task_unblock(ctrl->waiter);
-    ctrl->waiter = NULL;
-  }
+  wake_up(&ctrl->wait);
 }
 
 int ide_pio_part_ioctl(ide_part_t *part, int cmd, void *args, int flags) {
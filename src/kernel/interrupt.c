@@ -1,15 +1,18 @@
 #include "../include/conix/interrupt.h"
+#include "../include/conix/apic.h"
 #include "../include/conix/assert.h"
 #include "../include/conix/debug.h"
 #include "../include/conix/global.h"
 #include "../include/conix/io.h"
+#include "../include/conix/kstat.h"
 #include "../include/conix/printk.h"
+#include "../include/conix/smp.h"
 #include "../include/conix/stdlib.h"
 
 #define LOG_DEBUG(fmt, args...) DEBUGK(fmt, ##args)
 // #define LOG_DEBUG(fmt, args...)
 
-#define ENTRY_SIZE 0x30
+#define ENTRY_SIZE 0x40
 
 #define PIC_M_CTRL 0x20 // ƬĿƶ˿
 #define PIC_M_DATA 0x21 // Ƭݶ˿
@@ -54,7 +57,23 @@ static char *messages[] = {
 };
 
 // ֪ͨжϿжϴ
+extern idle_stat_t idle_stat;
+
 void send_eoi(int vec) {
+  // ¼ CPU  hlt лѵж
+  cpu_t *cpu = cpu_current();
+  if (cpu->halted && vec >= IRQ_MASTER_NR &&
+      vec < IRQ_MASTER_NR + IDLE_IRQ_NR) {
+    cpu->halted = false;
+    idle_stat.wakeups[vec - IRQ_MASTER_NR]++;
+  }
+  // αжϲҪӦ
+  if (apic_enabled) {
+    if (vec >= IRQ_MASTER_NR && vec != LAPIC_SPURIOUS) {
+      lapic_eoi();
+    }
+    return;
+  }
   if (vec >= 0x20 && vec < 0x28) {
     outb(PIC_M_CTRL, PIC_EOI);
   }
@@ -71,6 +90,10 @@ void set_interrupt_handler(uint32 irq, handler_t handler) {
 
 void set_interrupt_mask(uint32 irq, bool enable) {
   assert(irq >= 0 && irq < 16);
+  if (apic_enabled) {
+    ioapic_mask(irq, enable);
+    return;
+  }
   uint16 port;
   if (irq < 8) {
     port = PIC_M_DATA;
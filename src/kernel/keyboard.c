@@ -6,6 +6,7 @@
 #include "../include/conix/io.h"
 #include "../include/conix/mutex.h"
 #include "../include/conix/task.h"
+#include "../include/conix/wait.h"
 
 #define LOG_DEBUG(fmt, args...) DEBUGK(fmt, ##args)
 
@@ -224,7 +225,7 @@ static char keymap[][4] = {
 };
 
 static lock_t lock;
-static task_t *waiter; // ȴ
+static wait_queue_t wait; // ȴ
 
 #define BUFFER_SIZE 64
 static char buf[BUFFER_SIZE]; // 뻺
@@ -338,20 +339,14 @@ void keyboard_handler(int vec) {
 
   // LOG_DEBUG("keydown %c\n", ch);
   fifo_put(&fifo, ch);
-  if (waiter != NULL) {
-    task_unblock(waiter);
-    waiter = NULL;
-  }
+  wake_up(&wait);
 }
 
 uint32 keyboard_read(void *dev, char *buf, uint32 count) {
   lock_acquire(&lock);
   int nr = 0;
   while (nr < count) {
-    while (fifo_empty(&fifo)) {
-      waiter = running_task();
-      task_block(waiter, NULL, TASK_BLOCKED);
-    }
+    wait_event(&wait, !fifo_empty(&fifo));
     buf[nr++] = fifo_get(&fifo);
   }
   lock_release(&lock);
@@ -366,7 +361,7 @@ void keyboard_init() {
 
   fifo_init(&fifo, buf, BUFFER_SIZE);
   lock_init(&lock);
-  waiter = NULL;
+  wait_queue_init(&wait);
 
   // set_leds();
 
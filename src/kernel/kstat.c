@@ -0,0 +1,45 @@
+#include "../include/conix/kstat.h"
+#include "../include/conix/string.h"
+#include "../include/conix/task.h"
+
+extern tlb_stat_t tlb_stat;
+extern sched_stat_t sched_stat;
+extern idle_stat_t idle_stat;
+extern lock_stat_t lock_stat;
+extern uint32 volatile clock_ms;
+
+static uint32 tlb_cr3_reloads;
+static uint32 tlb_invlpgs;
+static uint32 idle_time;
+
+void kstat_tick() {
+  tlb_stat.cr3_rate = tlb_stat.cr3_reloads - tlb_cr3_reloads;
+  tlb_stat.invlpg_rate = tlb_stat.invlpgs - tlb_invlpgs;
+  tlb_cr3_reloads = tlb_stat.cr3_reloads;
+  tlb_invlpgs = tlb_stat.invlpgs;
+  idle_stat.idle_rate = idle_stat.idle - idle_time;
+  idle_time = idle_stat.idle;
+}
+
+int sys_kstat(kstat_type_t type, void *buf) {
+  switch (type) {
+  case KSTAT_TLB:
+    memcpy(buf, &tlb_stat, sizeof(tlb_stat_t));
+    return sizeof(tlb_stat_t);
+  case KSTAT_FAULT:
+    memcpy(buf, &running_task()->fault, sizeof(fault_stat_t));
+    return sizeof(fault_stat_t);
+  case KSTAT_SCHED:
+    memcpy(buf, &sched_stat, sizeof(sched_stat_t));
+    return sizeof(sched_stat_t);
+  case KSTAT_LOCK:
+    memcpy(buf, &lock_stat, sizeof(lock_stat_t));
+    return sizeof(lock_stat_t);
+  case KSTAT_IDLE:
+    idle_stat.uptime = clock_ms;
+    memcpy(buf, &idle_stat, sizeof(idle_stat_t));
+    return sizeof(idle_stat_t);
+  default:
+    return EOF;
+  }
+}
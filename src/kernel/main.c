@@ -15,6 +15,11 @@ extern void tss_init();
 extern void arena_init();
 extern void buffer_init();
 extern void hang();
+extern void smp_init();
+extern void smp_boot();
+extern void vdso_init();
+extern void uring_init();
+extern void super_init();
 
 void kernel_init() {
   tss_init();
@@ -22,17 +27,22 @@ void kernel_init() {
   mapping_init();
   arena_init();
   interrupt_init();
+  smp_init();
   clock_init();
   time_init();
   ide_init();
   keyboard_init();
   buffer_init();
+  super_init();
+  uring_init();
 
   // time_init();
   // rtc_init();
 
   task_init();
   syscall_init();
+  vdso_init();
+  smp_boot();
 
   set_interrupt_state(true);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "../include/conix/memory.h"
 #include "../include/conix/assert.h"
 #include "../include/conix/conix.h"
+#include "../include/conix/cpu.h"
 #include "../include/conix/debug.h"
+#include "../include/conix/kstat.h"
 #include "../include/conix/stdlib.h"
 #include "../include/conix/string.h"
 #include "../include/conix/task.h"
@@ -17,6 +19,7 @@
 #define TIDX(addr) (((uint32)addr >> 12) & 0x3ff) // ҳ
 #define PAGE(idx) ((uint32)idx << 12)             // Ӧҳʼַ
 #define ASSERT_PAGE(addr) assert((addr & 0xfff) == 0)
+#define PAGE_ALIGN(addr) (((uint32)addr + PAGE_SIZE - 1) & ~0xfff) // ϶
 
 #define PDE_MASK 0xFFC00000
 
@@ -25,6 +28,8 @@
 
 bitmap_t kernel_map;
 
+tlb_stat_t tlb_stat;
+
 typedef struct ards_t {
   uint64 base; // ڴַ
   uint64 size; // ڴ泤
@@ -144,8 +149,12 @@ uint32 get_cr3() { asm volatile("movl %cr3, %eax\n"); }
 void set_cr3(uint32 pde) {
   ASSERT_PAGE(pde);
   asm volatile("movl %%eax, %%cr3\n" ::"a"(pde));
+  tlb_stat.cr3_reloads++;
 }
 
+// ÿ CPU Ե cr3
+uint32 get_active_pde() { return get_cr3(); }
+
 // cr0ҳ
 static void enable_page() {
   asm volatile("movl %cr0, %eax\n"
@@ -167,16 +176,36 @@ void mapping_init() {
   page_entry_t *pde = (page_entry_t *)KERNEL_PAGE_DIR;
   memset(pde, 0, PAGE_SIZE);
 
+  // ֧ʱ˻ȫʹ 4K ҳ
+  bool pse = cpu_has(CPU_FEATURE_PSE);
+  bool pge = cpu_has(CPU_FEATURE_PGE);
+  if (pse) {
+    set_cr4(get_cr4() | CR4_PSE);
+  }
+
+  idx_t index = 0;
   for (idx_t didx = 0; didx < (sizeof(KERNEL_PAGE_TABLE) / 4); ++didx) {
+    page_entry_t *dentry = &pde[didx];
+
+    // һ 4M ҳ0 ַ copy_page ʱӳ
+    if (didx && pse) {
+      entry_init(dentry, index);
+      dentry->user = 0;
+      dentry->pat = 1; // ҳĿ¼Ϊ PS λֱӳ 4M
+      dentry->global = pge;
+      for (size_t tidx = 0; tidx < 1024; ++tidx, ++index) {
+        memory_map[index] = 1;
+      }
+      continue;
+    }
+
     page_entry_t *pte = (page_entry_t *)KERNEL_PAGE_TABLE[didx];
     memset(pte, 0, PAGE_SIZE);
     // ӳҳĿ¼
-    page_entry_t *dentry = &pde[didx];
     entry_init(dentry, IDX((uint32)pte));
     dentry->user = 0; // ֻܱں˷
 
     // ӳҳ
-    idx_t index = 0;
     for (size_t tidx = 0; tidx < 1024; ++tidx, ++index) {
       if (index == 0) {
         continue;
@@ -184,6 +213,7 @@ void mapping_init() {
       page_entry_t *tentry = &pte[tidx];
       entry_init(tentry, index);
       tentry->user = 0;
+      tentry->global = pge; // лҳĿ¼ʱˢں TLB
       memory_map[index] = 1;
     }
   }
@@ -194,6 +224,10 @@ void mapping_init() {
 
   set_cr3((uint32)pde);
   enable_page();
+
+  if (pge) {
+    set_cr4(get_cr4() | CR4_PGE);
+  }
 }
 
 static page_entry_t *get_pde() { return (page_entry_t *)(0xfffff000); }
@@ -211,14 +245,71 @@ static page_entry_t *get_pte(uint32 vaddr, bool create) {
   if (!entry->present) {
     LOG_DEBUG("Get and create page table entry for 0x%p\n", vaddr);
     uint32 page = get_page();
+    entry_init(entry, IDX(page));
+    flush_tlb((uint32)table);
     memset(table, 0, PAGE_SIZE);
   }
 
   return table;
 }
 
+// ַǷѾӳ
+static bool page_present(uint32 vaddr) {
+  page_entry_t *pde = get_pde();
+  if (!pde[DIDX(vaddr)].present) {
+    return false;
+  }
+  page_entry_t *pte = get_pte(vaddr, false);
+  return pte[TIDX(vaddr)].present;
+}
+
 void flush_tlb(uint32 vaddr) {
   asm volatile("invlpg (%0)" ::"r"(vaddr) : "memory");
+  tlb_stat.invlpgs++;
+}
+
+void flush_tlb_range(uint32 vaddr, uint32 count) {
+  ASSERT_PAGE(vaddr);
+  if (count > TLB_FLUSH_MAX) {
+    set_cr3(get_cr3());
+    return;
+  }
+  for (size_t i = 0; i < count; ++i, vaddr += PAGE_SIZE) {
+    flush_tlb(vaddr);
+  }
+}
+
+void tlb_batch_init(tlb_batch_t *batch) {
+  batch->start = 0;
+  batch->count = 0;
+  batch->total = 0;
+}
+
+void tlb_batch_add(tlb_batch_t *batch, uint32 vaddr) {
+  ASSERT_PAGE(vaddr);
+  batch->total++;
+  // ˢ
+  if (batch->total > TLB_FLUSH_MAX) {
+    return;
+  }
+
+  if (batch->count && vaddr == batch->start + batch->count * PAGE_SIZE) {
+    batch->count++;
+    return;
+  }
+
+  flush_tlb_range(batch->start, batch->count);
+  batch->start = vaddr;
+  batch->count = 1;
+}
+
+void tlb_batch_flush(tlb_batch_t *batch) {
+  if (batch->total > TLB_FLUSH_MAX) {
+    set_cr3(get_cr3());
+  } else {
+    flush_tlb_range(batch->start, batch->count);
+  }
+  tlb_batch_init(batch);
 }
 
 static uint32 scan_page(bitmap_t *map, uint32 count) {
@@ -283,7 +374,38 @@ void link_page(uint32 vaddr) {
   LOG_DEBUG("LINK from 0x%p to 0x%p", vaddr, paddr);
 }
 
-void unlink_page(uint32 vaddr) {
+void link_mmio(uint32 addr) {
+  ASSERT_PAGE(addr);
+  assert(DIDX(addr) >= DIDX(USER_STACK_TOP) && DIDX(addr) < 1023);
+
+  page_entry_t *pte = get_pte(addr, true);
+  page_entry_t *dentry = &get_pde()[DIDX(addr)];
+  dentry->user = 0;
+
+  page_entry_t *entry = &pte[TIDX(addr)];
+  entry_init(entry, IDX(addr));
+  entry->user = 0;
+  entry->pwt = 1;
+  entry->pcd = 1; // 豸Ĵܻ
+  flush_tlb(addr);
+}
+
+void link_shared(uint32 vaddr, uint32 paddr) {
+  ASSERT_PAGE(vaddr);
+  ASSERT_PAGE(paddr);
+  assert(DIDX(vaddr) >= DIDX(USER_STACK_TOP) && DIDX(vaddr) < 1023);
+
+  // ҳںҳĿ¼У֮ copy_pde ƵҳĿ¼ָ
+  page_entry_t *pte = get_pte(vaddr, true);
+
+  page_entry_t *entry = &pte[TIDX(vaddr)];
+  entry_init(entry, IDX(paddr));
+  entry->write = 0;
+  flush_tlb(vaddr);
+}
+
+// ȡӳ䵫ˢ TLBǷӳ
+static bool unmap_page(uint32 vaddr) {
   ASSERT_PAGE(vaddr);
 
   page_entry_t *pte = get_pte(vaddr, true);
@@ -295,7 +417,7 @@ void unlink_page(uint32 vaddr) {
 
   if (!entry->present) {
     assert(!bitmap_test(map, index));
-    return;
+    return false;
   }
 
   assert(entry->present && bitmap_test(map, index));
@@ -306,8 +428,13 @@ void unlink_page(uint32 vaddr) {
   uint32 paddr = PAGE(entry->index);
   LOG_DEBUG("UNLINK from 0x%p to 0x%p", vaddr, paddr);
   put_page(paddr);
+  return true;
+}
 
-  flush_tlb(vaddr);
+void unlink_page(uint32 vaddr) {
+  if (unmap_page(vaddr)) {
+    flush_tlb(vaddr);
+  }
 }
 
 static uint32 copy_page(void *page) {
@@ -315,6 +442,7 @@ static uint32 copy_page(void *page) {
 
   page_entry_t *entry = get_pte(0, false);
   entry_init(entry, IDX(paddr));
+  flush_tlb(0);
   memcpy((void *)0, (void *)page, PAGE_SIZE);
 
   entry->present = false;
@@ -330,8 +458,11 @@ page_entry_t *copy_pde() {
   entry_init(entry, IDX(pde));
 
   page_entry_t *dentry;
+  tlb_batch_t batch;
+  tlb_batch_init(&batch);
 
-  for (size_t didx = (sizeof(KERNEL_PAGE_TABLE) / 4); didx < 1023; ++didx) {
+  for (size_t didx = (sizeof(KERNEL_PAGE_TABLE) / 4);
+       didx < DIDX(USER_STACK_TOP); ++didx) {
     dentry = &pde[didx];
     if (!dentry->present) {
       continue;
@@ -347,7 +478,10 @@ page_entry_t *copy_pde() {
 
       assert(memory_map[entry->index] > 0);
       // Ϊֻдʱᷢȱҳ쳣
-      entry->write = false;
+      if (entry->write) {
+        entry->write = false;
+        tlb_batch_add(&batch, PAGE((didx << 10) | tidx));
+      }
       memory_map[entry->index]++;
     }
     // ҳ
@@ -355,7 +489,7 @@ page_entry_t *copy_pde() {
     dentry->index = IDX(paddr);
   }
 
-  set_cr3(task->pde);
+  tlb_batch_flush(&batch);
   return pde;
 }
 
@@ -365,7 +499,8 @@ void free_pde() {
 
   page_entry_t *pde = get_pde();
 
-  for (size_t didx = 2; didx < 1023; ++didx) {
+  for (size_t didx = (sizeof(KERNEL_PAGE_TABLE) / 4);
+       didx < DIDX(USER_STACK_TOP); ++didx) {
     page_entry_t *dentry = &pde[didx];
     if (!dentry->present) {
       continue;
@@ -391,21 +526,42 @@ void free_pde() {
 int32 sys_brk(void *addr) {
   LOG_DEBUG("task brk 0x%p\n", addr);
 
-  uint32 brk = (uint32)addr;
-  ASSERT_PAGE(brk);
-
   task_t *task = running_task();
   assert(task->uid != KERNEL_USER);
-  assert(KERNEL_MEMORY_SIZE < brk && brk < USER_STACK_BOTTOM);
 
-  uint32 old_brk = task->brk;
+  uint32 brk = (uint32)addr;
+  // brk(0) صǰѶ sbrk
+  if (!brk) {
+    return task->brk;
+  }
+  if (brk < KERNEL_MEMORY_SIZE || brk >= USER_STACK_BOTTOM) {
+    return EOF;
+  }
 
-  if (old_brk < brk) {
-    for (uint32 page = brk; brk < old_brk; brk += PAGE_SIZE) {
-      unlink_page(page);
+  // Ѷҳı߽
+  uint32 old_end = PAGE_ALIGN(task->brk);
+  uint32 new_end = PAGE_ALIGN(brk);
+
+  if (new_end < old_end) {
+    // նѶϵҳTLB ˢ
+    tlb_batch_t batch;
+    tlb_batch_init(&batch);
+    for (uint32 page = new_end; page < old_end; page += PAGE_SIZE) {
+      if (page_present(page) && unmap_page(page)) {
+        tlb_batch_add(&batch, page);
+      }
+    }
+    tlb_batch_flush(&batch);
+  } else if ((new_end - old_end) / PAGE_SIZE > free_pages) {
+    return EOF;
+  } else {
+    // Ԥӳ¶ѿռ俪ͷҳҳȱҳ
+    uint32 end = MIN(new_end, old_end + BRK_PREFAULT * PAGE_SIZE);
+    for (uint32 page = old_end; page < end; page += PAGE_SIZE) {
+      if (!page_present(page)) {
+        link_page(page);
+      }
     }
-  } else if (IDX((brk - old_brk)) > free_pages) {
-    return -1;
   }
 
   task->brk = brk;
@@ -425,6 +581,33 @@ typedef struct page_error_code_t {
   uint16 reserved2;
 } _packed page_error_code_t;
 
+// ӳȱҳڵҳӳ䣬ջӳ
+// ȱҳʹڷ˻һҳ
+static void fault_around(task_t *task, uint32 page, uint32 start, uint32 end) {
+  fault_stat_t *stat = &task->fault;
+  bool stack = start == USER_STACK_BOTTOM;
+
+  stat->faults++;
+  if (page == stat->next) {
+    stat->window = MIN(stat->window * 2, FAULT_AROUND_MAX);
+  } else {
+    stat->window = 1;
+  }
+
+  uint32 vaddr = page;
+  for (size_t i = 0; i < stat->window; ++i) {
+    if (vaddr < start || vaddr >= end) {
+      break;
+    }
+    if (!page_present(vaddr)) {
+      link_page(vaddr);
+      stat->pages++;
+    }
+    vaddr = stack ? vaddr - PAGE_SIZE : vaddr + PAGE_SIZE;
+  }
+  stat->next = vaddr;
+}
+
 void page_fault(uint32 vector, uint32 edi, uint32 esi, uint32 ebp, uint32 esp,
                 uint32 ebx, uint32 edx, uint32 ecx, uint32 eax, uint32 gs,
                 uint32 fs, uint32 es, uint32 ds, uint32 vector0, uint32 error,
@@ -460,9 +643,13 @@ void page_fault(uint32 vector, uint32 edi, uint32 esi, uint32 ebp, uint32 esp,
     return;
   }
 
-  if (!code->present && (vaddr < task->brk || vaddr >= USER_STACK_BOTTOM)) {
-    uint32 page = PAGE(IDX(vaddr));
-    link_page(page);
+  if (!code->present && vaddr < PAGE_ALIGN(task->brk)) {
+    fault_around(task, PAGE(IDX(vaddr)), KERNEL_MEMORY_SIZE,
+                 PAGE_ALIGN(task->brk));
+    return;
+  }
+  if (!code->present && vaddr >= USER_STACK_BOTTOM) {
+    fault_around(task, PAGE(IDX(vaddr)), USER_STACK_BOTTOM, USER_STACK_TOP);
     return;
   }
   panic("page fault!!!\n");
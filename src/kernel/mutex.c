@@ -1,12 +1,69 @@
 #include "../include/conix/mutex.h"
 #include "../include/conix/assert.h"
 #include "../include/conix/conix.h"
+#include "../include/conix/cpu.h"
 #include "../include/conix/interrupt.h"
+#include "../include/conix/smp.h"
+#include "../include/conix/stdlib.h"
+#include "../include/conix/string.h"
 #include "../include/conix/task.h"
 
+lock_stat_t lock_stat;
+
+void spin_init(spinlock_t *lock) { lock->locked = 0; }
+
+void spin_lock(spinlock_t *lock) {
+  while (xchg(&lock->locked, 1)) {
+    // ֻȴ
+    while (lock->locked) {
+      cpu_relax();
+    }
+  }
+}
+
+bool spin_trylock(spinlock_t *lock) { return !xchg(&lock->locked, 1); }
+
+void spin_unlock(spinlock_t *lock) {
+  assert(lock->locked);
+  xchg(&lock->locked, 0);
+}
+
 void mutex_init(mutex_t *mutex) {
   mutex->value = false;
-  list_init(&mutex->waiters);
+  mutex->owner = NULL;
+  wait_queue_init(&mutex->wait);
+  memset(&mutex->stat, 0, sizeof(lock_stat_t));
+}
+
+//  CPU Уٽܿܺܿſںȴ
+static bool mutex_spin(mutex_t *mutex) {
+  task_t *owner = mutex->owner;
+  if (!owner || owner == running_task() || owner->state != TASK_RUNNING) {
+    return false;
+  }
+
+  uint32 depth = kernel_unlock_all();
+  for (size_t i = 0; i < MUTEX_SPIN_MAX && mutex->value; ++i) {
+    owner = mutex->owner;
+    if (!owner || owner->state != TASK_RUNNING) {
+      break;
+    }
+    cpu_relax();
+  }
+  kernel_lock_all(depth);
+  return !mutex->value;
+}
+
+static void mutex_account(lock_stat_t *stat, bool contended, bool spin,
+                          uint32 wait) {
+  stat->acquisitions++;
+  if (!contended) {
+    return;
+  }
+  stat->contended++;
+  stat->spins += spin;
+  stat->wait += wait;
+  stat->wait_max = MAX(stat->wait_max, wait);
 }
 
 void mutex_lock(mutex_t *mutex) {
@@ -14,13 +71,27 @@ void mutex_lock(mutex_t *mutex) {
   bool intr = interrupt_disable();
 
   task_t *cur = running_task();
-  while (mutex->value == true) {
-    task_block(cur, &mutex->waiters, TASK_BLOCKED);
+  bool contended = mutex->value;
+  bool spin = false;
+  uint32 start = sched_clock();
+
+  if (contended) {
+    spin = mutex_spin(mutex);
+    // ͷ߰ѻֱתȴߣᱻ
+    while (mutex->value && mutex->owner != cur) {
+      wait_sleep(&mutex->wait, true);
+    }
   }
 
-  assert(mutex->value == false);
-  mutex->value++;
-  assert(mutex->value == true);
+  if (!mutex->value) {
+    mutex->value = true;
+    mutex->owner = cur;
+  }
+  assert(mutex->owner == cur);
+
+  uint32 wait = sched_clock() - start;
+  mutex_account(&mutex->stat, contended, spin, wait);
+  mutex_account(&lock_stat, contended, spin, wait);
 
   set_interrupt_state(intr);
 }
@@ -28,37 +99,97 @@ void mutex_lock(mutex_t *mutex) {
 void mutex_unlock(mutex_t *mutex) {
   bool intr = interrupt_disable();
 
-  mutex->value--;
-  assert(mutex->value == false);
+  assert(mutex->value == true);
+  assert(mutex->owner == running_task());
 
-  if (!list_empty(&mutex->waiters)) {
-    task_t *task = element_entry(task_t, node, mutex->waiters.tail.prev);
-    assert(task->magic == CONIX_MAGIC);
-    task_unblock(task);
-    // ֤½̻ûֹ
-    task_yield();
+  // еȴʱּ״ֱ̬תǿл
+  task_t *next = wait_handoff(&mutex->wait);
+  if (next) {
+    mutex->owner = next;
+  } else {
+    mutex->owner = NULL;
+    mutex->value = false;
   }
 
   set_interrupt_state(intr);
 }
 
+// ȼŵȴഫݵĲ
+#define LOCK_CHAIN_MAX 8
+
+// ʼ֮ǰ׶β¼е
+#define lock_tracked(task) ((task)->magic == CONIX_MAGIC)
+
 void lock_init(lock_t *lock) {
   lock->holder = NULL;
   lock->repeat = 0;
+  lock->node.next = NULL;
+  lock->node.prev = NULL;
   mutex_init(&lock->mutex);
 }
 
+// ߵȨߵ weightҲڵʱ´
+static void lock_boost(task_t *task, uint32 weight) {
+  for (size_t i = 0; task && i < LOCK_CHAIN_MAX; ++i) {
+    if (task->weight >= weight) {
+      break;
+    }
+    task->weight = weight;
+    if (!task->blocked_on) {
+      break;
+    }
+    task = task->blocked_on->mutex.owner;
+  }
+}
+
+void lock_reweight(task_t *task) {
+  uint32 weight = task_base_weight(task);
+
+  list_t *locks = &task->locks;
+  for (list_node_t *node = locks->head.next; node != &locks->tail;
+       node = node->next) {
+    lock_t *lock = element_entry(lock_t, node, node);
+    list_t *waiters = &lock->mutex.wait.exclusive;
+    for (list_node_t *wnode = waiters->head.next; wnode != &waiters->tail;
+         wnode = wnode->next) {
+      task_t *waiter = element_entry(task_t, node, wnode);
+      weight = MAX(weight, waiter->weight);
+    }
+  }
+  task->weight = weight;
+}
+
 void lock_acquire(lock_t *lock) {
   task_t *cur = running_task();
 
-  if (lock->holder != cur) {
-    mutex_lock(&lock->mutex);
-    lock->holder = cur;
-    assert(lock->repeat == 0);
-    lock->repeat = 1;
-  } else {
+  if (lock->holder == cur) {
     lock->repeat++;
+    return;
+  }
+
+  bool intr = interrupt_disable();
+  bool tracked = lock_tracked(cur);
+
+  // ת֮ holder ûã owner Ϊ׼
+  task_t *owner = lock->mutex.owner;
+  if (tracked && owner) {
+    cur->blocked_on = lock;
+    lock_boost(owner, cur->weight);
   }
+
+  mutex_lock(&lock->mutex);
+  lock->holder = cur;
+  assert(lock->repeat == 0);
+  lock->repeat = 1;
+
+  if (tracked) {
+    cur->blocked_on = NULL;
+    list_insert_after(&cur->locks.head, &lock->node);
+    // ̳ڵȴ
+    lock_reweight(cur);
+  }
+
+  set_interrupt_state(intr);
 }
 
 void lock_release(lock_t *lock) {
@@ -71,7 +202,84 @@ void lock_release(lock_t *lock) {
   }
 
   assert(lock->repeat == 1);
+  bool intr = interrupt_disable();
+
   lock->holder = NULL;
   lock->repeat = 0;
   mutex_unlock(&lock->mutex);
+
+  // ٳָʣȴ߾Ȩ
+  if (lock_tracked(cur) && lock->node.next) {
+    list_remove(&lock->node);
+    lock_reweight(cur);
+  }
+
+  set_interrupt_state(intr);
+}
+
+void rwlock_init(rwlock_t *rw) {
+  rw->readers = 0;
+  rw->writers = 0;
+  rw->writer = NULL;
+  wait_queue_init(&rw->wait);
+}
+
+// ѾУȰдתдߣûдʱж
+static void rwlock_wakeup(rwlock_t *rw) {
+  task_t *next = wait_handoff(&rw->wait);
+  if (next) {
+    rw->writer = next;
+  } else {
+    wait_wakeup(&rw->wait, 0);
+  }
+}
+
+void read_lock(rwlock_t *rw) {
+  bool intr = interrupt_disable();
+
+  assert(rw->writer != running_task());
+  wait_event(&rw->wait, !rw->writer && !rw->writers);
+  rw->readers++;
+
+  set_interrupt_state(intr);
+}
+
+void read_unlock(rwlock_t *rw) {
+  bool intr = interrupt_disable();
+
+  assert(rw->readers > 0);
+  if (!--rw->readers) {
+    rwlock_wakeup(rw);
+  }
+
+  set_interrupt_state(intr);
+}
+
+void write_lock(rwlock_t *rw) {
+  bool intr = interrupt_disable();
+
+  task_t *cur = running_task();
+  assert(rw->writer != cur);
+  if (rw->writer || rw->readers || rw->writers) {
+    // ȺŶӣͷֱת
+    rw->writers++;
+    while (rw->writer != cur) {
+      wait_sleep(&rw->wait, true);
+    }
+    rw->writers--;
+  } else {
+    rw->writer = cur;
+  }
+
+  set_interrupt_state(intr);
+}
+
+void write_unlock(rwlock_t *rw) {
+  bool intr = interrupt_disable();
+
+  assert(rw->writer == running_task());
+  rw->writer = NULL;
+  rwlock_wakeup(rw);
+
+  set_interrupt_state(intr);
 }
@@ -0,0 +1,418 @@
+#include "../include/conix/smp.h"
+#include "../include/conix/apic.h"
+#include "../include/conix/arena.h"
+#include "../include/conix/assert.h"
+#include "../include/conix/cpu.h"
+#include "../include/conix/debug.h"
+#include "../include/conix/interrupt.h"
+#include "../include/conix/io.h"
+#include "../include/conix/kstat.h"
+#include "../include/conix/memory.h"
+#include "../include/conix/mutex.h"
+#include "../include/conix/string.h"
+#include "../include/conix/task.h"
+#include "../include/conix/vdso.h"
+
+#define LOG_DEBUG(fmt, args...) DEBUGK(fmt, ##args)
+
+#define IRQ_NR 16
+
+// MP ָṹ
+typedef struct mp_float_t {
+  char signature[4]; // "_MP_"
+  uint32 config;     // ñַ
+  uint8 length;      //  16 ֽΪλ
+  uint8 version;
+  uint8 checksum;
+  uint8 feature1;
+  uint8 feature2; //  7 λʾ IMCR
+  uint8 reserved[3];
+} _packed mp_float_t;
+
+// MP ñͷ֮ entry_count 
+typedef struct mp_config_t {
+  char signature[4]; // "PCMP"
+  uint16 length;
+  uint8 version;
+  uint8 checksum;
+  char oem[20];
+  uint32 oem_table;
+  uint16 oem_length;
+  uint16 entry_count;
+  uint32 lapic; //  APIC ַ
+  uint16 ext_length;
+  uint8 ext_checksum;
+  uint8 reserved;
+} _packed mp_config_t;
+
+enum mp_entry_type_t {
+  MP_PROCESSOR, // 20 ֽ
+  MP_BUS,       // ߣ¶ 8 ֽ
+  MP_IOAPIC,
+  MP_IOINTR, // IOAPIC ж
+  MP_LINTR,  // ж
+};
+
+typedef struct mp_processor_t {
+  uint8 type;
+  uint8 apic_id;
+  uint8 version;
+  uint8 flags; //  0 λã 1 λΪ
+  uint32 signature;
+  uint32 feature;
+  uint32 reserved[2];
+} _packed mp_processor_t;
+
+typedef struct mp_bus_t {
+  uint8 type;
+  uint8 id;
+  char name[6];
+} _packed mp_bus_t;
+
+typedef struct mp_ioapic_t {
+  uint8 type;
+  uint8 id;
+  uint8 version;
+  uint8 flags; //  0 λ
+  uint32 addr;
+} _packed mp_ioapic_t;
+
+typedef struct mp_iointr_t {
+  uint8 type;
+  uint8 intr;   // 0 Ϊͨж
+  uint16 flags; // 0 ~ 1 λԣ2 ~ 3 λʽ
+  uint8 bus;
+  uint8 irq;
+  uint8 apic_id;
+  uint8 pin;
+} _packed mp_iointr_t;
+
+#define MP_PROCESSOR_ENABLED 1
+#define MP_PROCESSOR_BSP 2
+#define MP_IMCR (1 << 7)
+
+#define MP_POLARITY_LOW 0b11
+#define MP_TRIGGER_LEVEL 0b11
+
+// IOAPIC ض
+#define IOAPIC_ACTIVE_LOW (1 << 13)
+#define IOAPIC_LEVEL (1 << 15)
+
+// ʵģʽ룬 trampoline.asm 
+extern char ap_trampoline_start[];
+extern char ap_trampoline_end[];
+extern pointer_t ap_gdt_ptr;
+extern uint32 ap_cr3;
+extern uint32 ap_cr4;
+extern uint32 ap_stack;
+extern uint32 ap_entry;
+
+// бƵ AP_BOOT_ADDR ֮λ
+#define AP_PARAM(var)                                                          \
+  ((void *)(AP_BOOT_ADDR + ((uint32)&(var) - (uint32)ap_trampoline_start)))
+
+extern pointer_t gdt_ptr;
+extern tss_t tss;
+extern handler_t handler_table[IDT_SIZE];
+extern idle_stat_t idle_stat;
+extern void idle_thread();
+extern void clock_delay(uint32 us);
+
+cpu_t cpus[CPU_MAX];
+uint32 cpu_count;
+bool smp_enabled;
+
+static spinlock_t kernel_spin;
+
+static uint32 ioapic_addr;
+static uint32 irq_pins[IRQ_NR];  // ISA ж϶Ӧ IOAPIC 
+static uint32 irq_flags[IRQ_NR]; // Ժʹʽ
+static bool imcr_present;
+
+cpu_t *cpu_current() { return running_task()->cpu; }
+
+void kernel_lock() {
+  if (!smp_enabled) {
+    return;
+  }
+  cpu_t *cpu = cpu_current();
+  if (!cpu->lock_depth++) {
+    spin_lock(&kernel_spin);
+  }
+}
+
+void kernel_unlock() {
+  if (!smp_enabled) {
+    return;
+  }
+  cpu_t *cpu = cpu_current();
+  assert(cpu->lock_depth > 0);
+  if (!--cpu->lock_depth) {
+    spin_unlock(&kernel_spin);
+  }
+}
+
+uint32 kernel_unlock_all() {
+  if (!smp_enabled) {
+    return 0;
+  }
+  cpu_t *cpu = cpu_current();
+  uint32 depth = cpu->lock_depth;
+  if (depth) {
+    cpu->lock_depth = 0;
+    spin_unlock(&kernel_spin);
+  }
+  return depth;
+}
+
+void kernel_lock_all(uint32 depth) {
+  if (!depth) {
+    return;
+  }
+  spin_lock(&kernel_spin);
+  cpu_current()->lock_depth = depth;
+}
+
+void cpu_kick(cpu_t *cpu) {
+  if (!smp_enabled) {
+    return;
+  }
+
+  cpu_t *self = cpu_current();
+  // Ŀ CPU ʱһе CPU ȡ
+  if (cpu == self || cpu->current != cpu->idle) {
+    cpu = NULL;
+    for (size_t i = 0; i < cpu_count; ++i) {
+      if (&cpus[i] != self && cpus[i].started &&
+          cpus[i].current == cpus[i].idle) {
+        cpu = &cpus[i];
+        break;
+      }
+    }
+  }
+  if (cpu && cpu->started) {
+    lapic_send_ipi(cpu->apic_id, IPI_RESCHEDULE);
+  }
+}
+
+static bool mp_checksum(void *addr, uint32 len) {
+  uint32 sum = 0;
+  for (uint32 i = 0; i < len; ++i) {
+    sum += ((uint8 *)addr)[i] & 0xff;
+  }
+  return (sum & 0xff) == 0;
+}
+
+static mp_float_t *mp_search(uint32 addr, uint32 len) {
+  for (uint32 end = addr + len; addr < end; addr += 16) {
+    mp_float_t *mp = (mp_float_t *)addr;
+    if (!memcmp(mp->signature, "_MP_", 4) &&
+        mp_checksum(mp, (mp->length & 0xff) * 16)) {
+      return mp;
+    }
+  }
+  return NULL;
+}
+
+//  MP 淶жϱ־ת IOAPIC ضλISA Ĭϸߵƽش
+static uint32 mp_irq_flags(uint16 flags) {
+  uint32 value = 0;
+  if ((flags & 0b11) == MP_POLARITY_LOW) {
+    value |= IOAPIC_ACTIVE_LOW;
+  }
+  if (((flags >> 2) & 0b11) == MP_TRIGGER_LEVEL) {
+    value |= IOAPIC_LEVEL;
+  }
+  return value;
+}
+
+void smp_init() {
+  cpu_count = 1;
+  smp_enabled = false;
+  spin_init(&kernel_spin);
+  memset(cpus, 0, sizeof(cpus));
+
+  cpus[0].tss = &tss;
+  idle_stat.cpus = 1;
+
+  if (!cpu_has(CPU_FEATURE_APIC)) {
+    return;
+  }
+
+  // չ BIOS ָڵ 0 ҳûӳ䣬ֻһڴ 1K
+  mp_float_t *mp = mp_search(0x9fc00, 0x400);
+  if (!mp) {
+    mp = mp_search(0xf0000, 0x10000);
+  }
+  // ûñĬò֧
+  if (!mp || !mp->config) {
+    return;
+  }
+
+  mp_config_t *config = (mp_config_t *)mp->config;
+  if (memcmp(config->signature, "PCMP", 4) ||
+      !mp_checksum(config, config->length) || config->lapic != LAPIC_BASE) {
+    return;
+  }
+
+  for (size_t irq = 0; irq < IRQ_NR; ++irq) {
+    irq_pins[irq] = irq;
+    irq_flags[irq] = 0;
+  }
+
+  uint32 count = 1;
+  int isa_bus = -1;
+  ioapic_addr = 0;
+
+  char *entry = (char *)(config + 1);
+  for (size_t i = 0; i < config->entry_count; ++i) {
+    switch (*entry) {
+    case MP_PROCESSOR: {
+      mp_processor_t *proc = (mp_processor_t *)entry;
+      entry += sizeof(mp_processor_t);
+      if (!(proc->flags & MP_PROCESSOR_ENABLED)) {
+        break;
+      }
+      if (proc->flags & MP_PROCESSOR_BSP) {
+        cpus[0].apic_id = proc->apic_id & 0xff;
+      } else if (count < CPU_MAX) {
+        cpus[count++].apic_id = proc->apic_id & 0xff;
+      }
+      break;
+    }
+    case MP_BUS: {
+      mp_bus_t *bus = (mp_bus_t *)entry;
+      entry += sizeof(mp_bus_t);
+      if (!memcmp(bus->name, "ISA", 3)) {
+        isa_bus = bus->id & 0xff;
+      }
+      break;
+    }
+    case MP_IOAPIC: {
+      mp_ioapic_t *ioapic = (mp_ioapic_t *)entry;
+      entry += sizeof(mp_ioapic_t);
+      // ֻʹõһ IOAPIC
+      if ((ioapic->flags & 1) && !ioapic_addr) {
+        ioapic_addr = ioapic->addr;
+      }
+      break;
+    }
+    case MP_IOINTR: {
+      mp_iointr_t *intr = (mp_iointr_t *)entry;
+      entry += sizeof(mp_iointr_t);
+      uint32 irq = intr->irq & 0xff;
+      if (!intr->intr && (intr->bus & 0xff) == isa_bus && irq < IRQ_NR) {
+        irq_pins[irq] = intr->pin & 0xff;
+        irq_flags[irq] = mp_irq_flags(intr->flags);
+      }
+      break;
+    }
+    case MP_LINTR:
+      entry += sizeof(mp_iointr_t);
+      break;
+    default:
+      LOG_DEBUG("unknown mp entry type %d\n", *entry);
+      return;
+    }
+  }
+
+  // ֻһʱʹ 8259
+  if (count == 1 || !ioapic_addr || ioapic_addr & 0xfff) {
+    return;
+  }
+
+  imcr_present = mp->feature2 & MP_IMCR;
+  cpu_count = count;
+  for (size_t i = 0; i < cpu_count; ++i) {
+    cpus[i].id = i;
+  }
+  for (size_t i = 1; i < cpu_count; ++i) {
+    cpus[i].tss = (tss_t *)kmalloc(sizeof(tss_t));
+  }
+  LOG_DEBUG("smp %d cpus, ioapic 0x%p\n", cpu_count, ioapic_addr);
+}
+
+static void lapic_timer_handler(int vector) {
+  send_eoi(vector);
+  task_tick();
+}
+
+// ѵĿ CPU жϷغԼ
+static void reschedule_handler(int vector) { send_eoi(vector); }
+
+// Ӧôҳںˣջڿҳ
+static void ap_main() {
+  cpu_t *cpu = running_task()->cpu;
+
+  asm volatile("lidt idt_ptr\n");
+  tss_load(cpu->tss, CPU_TSS_IDX + cpu->id - 1);
+  sysenter_init();
+
+  lapic_init();
+  lapic_timer_init();
+
+  cpu->current = cpu->idle;
+  cpu->idle->state = TASK_RUNNING;
+  cpu->started = true;
+
+  kernel_lock();
+  idle_stat.cpus++;
+  LOG_DEBUG("cpu %d started\n", cpu->id);
+  idle_thread();
+}
+
+void smp_boot() {
+  if (cpu_count == 1) {
+    return;
+  }
+
+  link_mmio(LAPIC_BASE);
+  link_mmio(ioapic_addr);
+
+  //  8259 Ӵ INTR л APIC
+  if (imcr_present) {
+    outb(0x22, 0x70);
+    outb(0x23, inb(0x23) | 1);
+  }
+
+  lapic_init();
+  assert(lapic_id() == cpus[0].apic_id);
+
+  ioapic_init(ioapic_addr);
+  for (size_t irq = 0; irq < IRQ_NR; ++irq) {
+    if (irq != IRQ_CASCADE) {
+      ioapic_route(irq, irq_pins[irq], irq_flags[irq], cpus[0].apic_id);
+    }
+  }
+  apic_enable();
+
+  handler_table[LAPIC_TIMER_VECTOR] = lapic_timer_handler;
+  handler_table[IPI_RESCHEDULE] = reschedule_handler;
+  // Ȼ PIT ʱʱֻӦô
+  lapic_timer_calibrate();
+
+  // ￪ʼдںֱһε
+  smp_enabled = true;
+  kernel_lock();
+
+  memcpy((void *)AP_BOOT_ADDR, ap_trampoline_start,
+         ap_trampoline_end - ap_trampoline_start);
+  memcpy(AP_PARAM(ap_gdt_ptr), &gdt_ptr, sizeof(pointer_t));
+  *(uint32 *)AP_PARAM(ap_cr3) = KERNEL_PAGE_DIR;
+  *(uint32 *)AP_PARAM(ap_cr4) = get_cr4();
+  *(uint32 *)AP_PARAM(ap_entry) = (uint32)ap_main;
+
+  for (size_t i = 1; i < cpu_count; ++i) {
+    cpu_t *cpu = &cpus[i];
+    *(uint32 *)AP_PARAM(ap_stack) = (uint32)cpu->idle + PAGE_SIZE;
+
+    lapic_startup(cpu->apic_id, AP_BOOT_ADDR);
+    for (size_t ms = 0; ms < 100 && !cpu->started; ++ms) {
+      clock_delay(1000);
+    }
+    // ʧܵĴûŵĶ
+    if (!cpu->started) {
+      LOG_DEBUG("cpu %d apic %d not responding\n", i, cpu->apic_id);
+    }
+  }
+}
@@ -3,41 +3,323 @@
 #include "../include/conix/assert.h"
 #include "../include/conix/bitmap.h"
 #include "../include/conix/conix.h"
+#include "../include/conix/cpu.h"
 #include "../include/conix/debug.h"
 #include "../include/conix/global.h"
 #include "../include/conix/interrupt.h"
 #include "../include/conix/list.h"
 #include "../include/conix/memory.h"
+#include "../include/conix/mutex.h"
 #include "../include/conix/printk.h"
+#include "../include/conix/smp.h"
+#include "../include/conix/stdlib.h"
 #include "../include/conix/string.h"
 #include "../include/conix/syscall.h"
+#include "../include/conix/vdso.h"
 
-#define NR_TASKS 64
+#define PID_MAX (PAGE_SIZE * 8) // pid λͼռһҳ
+#define PID_HASH_NR 256
+
+#define pid_hashfn(pid) ((pid) & (PID_HASH_NR - 1))
 
 extern uint32 volatile jiffies;
-extern uint32 jiffy;
 extern bitmap_t kernel_map;
 extern void task_switch(task_t *next);
+extern void uring_exit(task_t *task);
 
-extern tss_t tss;
+static bitmap_t pid_map;
+static pid_t last_pid;
+static list_t pid_hash[PID_HASH_NR];
 
-static task_t *task_table[NR_TASKS];
 static list_t block_list;
-static list_t sleep_list;
-static task_t *idle_task;
+
+#define NICE_0_WEIGHT 1024
+// nice Ϊ 0 ÿʱжӵʱ
+#define VRUNTIME_TICK NICE_0_WEIGHT
+// ˯Ѻ min_vruntime ʱ
+#define SLEEPER_CREDIT (VRUNTIME_TICK * 3)
+// ȵǰ񳬹ֵʱռ
+#define WAKEUP_GRAN VRUNTIME_TICK
+
+#define vruntime_before(a, b) ((int32)((a) - (b)) < 0)
+
+// ʱƬΪֵ nice Ϊ 0ʱƬÿһʱж nice  1
+#define NICE_0_PRIORITY 5
+
+// nice  -20  19 ӦȨأԼ 1.25 
+static const uint32 nice_weight[NICE_MAX - NICE_MIN + 1] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+    1024,  820,   655,   526,   423,   335,   272,   215,   172,   137,
+    110,   87,    70,    56,    45,    36,    29,    23,    18,    15,
+};
+
+static bool tsc_support;
+sched_stat_t sched_stat;
+
+// ʹõʱӣ֧ TSC ʱΪ 0
+uint32 sched_clock() {
+  if (!tsc_support) {
+    return 0;
+  }
+  return (uint32)rdtsc();
+}
+
+// ʱȼõʼ nice
+static int priority_nice(uint32 priority) {
+  int nice = NICE_0_PRIORITY - (int)priority;
+  nice = MAX(nice, NICE_MIN);
+  return MIN(nice, NICE_MAX);
+}
+
+uint32 task_base_weight(task_t *task) {
+  return nice_weight[task->nice - NICE_MIN];
+}
+
+// ʱ
+static void heap_grow(runqueue_t *rq) {
+  uint32 pages = rq->capacity * sizeof(task_t *) / PAGE_SIZE;
+  task_t **heap = (task_t **)alloc_kpage(pages * 2);
+  memcpy(heap, rq->heap, rq->size * sizeof(task_t *));
+  free_kpage((uint32)rq->heap, pages);
+  rq->heap = heap;
+  rq->capacity *= 2;
+}
+
+static void heap_push(runqueue_t *rq, task_t *task) {
+  if (rq->size == rq->capacity) {
+    heap_grow(rq);
+  }
+
+  task_t **heap = rq->heap;
+  uint32 idx = rq->size++;
+  while (idx > 0) {
+    uint32 parent = (idx - 1) / 2;
+    if (!vruntime_before(task->vruntime, heap[parent]->vruntime)) {
+      break;
+    }
+    heap[idx] = heap[parent];
+    idx = parent;
+  }
+  heap[idx] = task;
+}
+
+static task_t *heap_pop(runqueue_t *rq) {
+  assert(rq->size > 0);
+
+  task_t **heap = rq->heap;
+  task_t *top = heap[0];
+  task_t *last = heap[--rq->size];
+
+  uint32 idx = 0;
+  while (true) {
+    uint32 child = idx * 2 + 1;
+    if (child >= rq->size) {
+      break;
+    }
+    if (child + 1 < rq->size &&
+        vruntime_before(heap[child + 1]->vruntime, heap[child]->vruntime)) {
+      child++;
+    }
+    if (!vruntime_before(heap[child]->vruntime, last->vruntime)) {
+      break;
+    }
+    heap[idx] = heap[child];
+    idx = child;
+  }
+  heap[idx] = last;
+  return top;
+}
+
+static void runqueue_init(runqueue_t *rq) {
+  rq->heap = (task_t **)alloc_kpage(1);
+  rq->size = 0;
+  rq->capacity = PAGE_SIZE / sizeof(task_t *);
+  rq->min_vruntime = 0;
+}
+
+// ڵ CPUڵǰ CPU
+static cpu_t *task_cpu(task_t *task) {
+  if (!task->cpu) {
+    task->cpu = cpu_current();
+  }
+  return task->cpu;
+}
+
+// ʱ䲻 min_vruntime - creditⳤʱ˯ߵռ CPU
+static void task_place(task_t *task, uint32 credit) {
+  uint32 floor = task_cpu(task)->rq.min_vruntime - credit;
+  if (vruntime_before(task->vruntime, floor)) {
+    task->vruntime = floor;
+  }
+}
+
+static void task_enqueue(task_t *task) {
+  assert(!get_interrupt_state()); // ж
+  assert(task->node.next == NULL && task->node.prev == NULL);
+
+  cpu_t *cpu = task_cpu(task);
+  if (task == cpu->idle) {
+    task->state = TASK_READY;
+    return;
+  }
+  heap_push(&cpu->rq, task);
+
+  task->state = TASK_READY;
+  task->ready = sched_clock();
+  if (task != running_task()) {
+    cpu_kick(cpu);
+  }
+}
+
+// Ӿ CPU ȡһ񣬰е min_vruntime 
+static task_t *task_steal(cpu_t *cpu) {
+  cpu_t *busiest = NULL;
+  for (size_t i = 0; i < cpu_count; ++i) {
+    cpu_t *other = &cpus[i];
+    if (other != cpu && other->rq.size &&
+        (!busiest || other->rq.size > busiest->rq.size)) {
+      busiest = other;
+    }
+  }
+  if (!busiest) {
+    return NULL;
+  }
+
+  task_t *task = heap_pop(&busiest->rq);
+  task->vruntime =
+      task->vruntime - busiest->rq.min_vruntime + cpu->rq.min_vruntime;
+  task->cpu = cpu;
+  return task;
+}
+
+// ȡʱС񣬱ضΪʱ CPU ȡ
+static task_t *task_dequeue(cpu_t *cpu) {
+  assert(!get_interrupt_state()); // ж
+
+  runqueue_t *rq = &cpu->rq;
+  task_t *task;
+  if (rq->size) {
+    task = heap_pop(rq);
+  } else if (!(task = task_steal(cpu))) {
+    return cpu->idle;
+  }
+
+  if (vruntime_before(rq->min_vruntime, task->vruntime)) {
+    rq->min_vruntime = task->vruntime;
+  }
+  return task;
+}
+
+// ϴη pid ֮ҿ pid
+static pid_t pid_alloc() {
+  for (size_t i = 1; i <= PID_MAX; ++i) {
+    pid_t pid = (last_pid + i) % PID_MAX;
+    if (!bitmap_test(&pid_map, pid)) {
+      bitmap_set(&pid_map, pid, true);
+      last_pid = pid;
+      return pid;
+    }
+  }
+  panic("No more task");
+}
+
+static task_t *task_find(pid_t pid) {
+  list_t *list = &pid_hash[pid_hashfn(pid)];
+  for (list_node_t *node = list->head.next; node != &list->tail;
+       node = node->next) {
+    task_t *task = element_entry(task_t, hnode, node);
+    if (task->pid == pid) {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+//  pid ϣ͸̵ӽ
+static void task_link(task_t *task, task_t *parent) {
+  list_insert_after(&pid_hash[pid_hashfn(task->pid)].head, &task->hnode);
+
+  list_init(&task->children);
+  task->sibling.next = NULL;
+  task->sibling.prev = NULL;
+  if (parent && parent != task) {
+    list_insert_after(&parent->children.head, &task->sibling);
+  }
+}
+
+// ̱գͷ pid
+static void task_unlink(task_t *task) {
+  list_remove(&task->hnode);
+  if (task->sibling.next) {
+    list_remove(&task->sibling);
+  }
+  bitmap_set(&pid_map, task->pid, false);
+}
 
 // һ
 static task_t *get_free_task() {
-  for (size_t i = 0; i < NR_TASKS; ++i) {
-    if (task_table[i] == NULL) {
-      task_t *task = (task_t *)alloc_kpage(1);
-      memset(task, 0, PAGE_SIZE);
-      task->pid = i;
-      task_table[i] = task;
-      return task;
+  task_t *task = (task_t *)alloc_kpage(1);
+  memset(task, 0, PAGE_SIZE);
+  task->pid = pid_alloc();
+  return task;
+}
+
+static void fd_table_init(fd_table_t *fdt, uint32 size) {
+  fdt->files = kmalloc(size * sizeof(file_t *));
+  memset(fdt->files, 0, size * sizeof(file_t *));
+  bitmap_init(&fdt->map, kmalloc(size / 8), size / 8, 0);
+  fdt->size = size;
+
+  for (fd_t fd = stdin; fd <= stderr; ++fd) {
+    bitmap_set(&fdt->map, fd, true);
+  }
+  fdt->next = stderr + 1;
+}
+
+static void fd_table_free(fd_table_t *fdt) {
+  kfree(fdt->files);
+  kfree(fdt->map.bits);
+}
+
+//  src  dstdst ĴСС src
+static void fd_table_copy(fd_table_t *dst, fd_table_t *src) {
+  assert(dst->size >= src->size);
+  memcpy(dst->files, src->files, src->size * sizeof(file_t *));
+  memcpy(dst->map.bits, src->map.bits, src->map.length);
+  dst->next = src->next;
+}
+
+static bool fd_table_grow(fd_table_t *fdt) {
+  if (fdt->size >= TASK_FILE_MAX) {
+    return false;
+  }
+
+  fd_table_t table;
+  fd_table_init(&table, fdt->size * 2);
+  fd_table_copy(&table, fdt);
+  fd_table_free(fdt);
+  *fdt = table;
+  return true;
+}
+
+// Ŀ¼ʹ򿪵ļ
+static void task_copy_fs(task_t *child, task_t *task) {
+  // pwd
+  child->pwd = (char *)alloc_kpage(1);
+  strncpy(child->pwd, task->pwd, PAGE_SIZE);
+  // Ŀ¼+1
+  task->ipwd->count++;
+  task->iroot->count++;
+  // ļ+1
+  fd_table_init(&child->fdt, task->fdt.size);
+  fd_table_copy(&child->fdt, &task->fdt);
+  for (size_t i = 0; i < task->fdt.size; ++i) {
+    file_t *file = task->fdt.files[i];
+    if (file) {
+      file->count++;
     }
   }
-  panic("No more task");
 }
 
 extern void interrupt_exit();
@@ -72,7 +354,13 @@ pid_t task_fork() {
   child->pid = pid;
   child->ppid = task->pid;
   child->ticks = child->priority;
-  child->state = TASK_READY;
+  child->vfork = false;
+  child->uring = NULL;
+  memset(&child->fault, 0, sizeof(fault_stat_t));
+  child->blocked_on = NULL;
+  list_init(&child->locks);
+  task_link(child, task);
+  task_place(child, 0);
 
   // ûڴλͼ
   child->vmap = kmalloc(sizeof(bitmap_t));
@@ -85,66 +373,121 @@ pid_t task_fork() {
   // ҳĿ¼
   child->pde = (uint32)copy_pde();
 
-  // pwd
-  child->pwd = (char *)alloc_kpage(1);
-  strncpy(child->pwd, task->pwd, PAGE_SIZE);
-  // Ŀ¼+1
-  task->ipwd->count++;
-  task->iroot->count++;
-  // ļ+1
-  for (size_t i = 0; i < TASK_FILE_NR; ++i) {
-    file_t *file = task->files[i];
-    if (file) {
-      file->count++;
-    }
-  }
+  task_copy_fs(child, task);
 
   task_build_stack(child);
 
+  task_enqueue(child);
+
   return child->pid;
 }
 
+pid_t task_vfork() {
+  task_t *task = running_task();
+
+  assert(task->node.next == NULL && task->node.prev == NULL &&
+         task->state == TASK_RUNNING);
+
+  // ֻpcbջж֡ӽֱӴϵͳ÷
+  task_t *child = get_free_task();
+  pid_t pid = child->pid;
+  memcpy(child, task, sizeof(task_t));
+
+  uint32 frame = PAGE_SIZE - sizeof(intr_frame_t);
+  memcpy((void *)child + frame, (void *)task + frame, sizeof(intr_frame_t));
+
+  child->pid = pid;
+  child->ppid = task->pid;
+  child->ticks = child->priority;
+
+  // ҳĿ¼ڴλͼҳ
+  child->vfork = true;
+  child->uring = NULL;
+  memset(&child->fault, 0, sizeof(fault_stat_t));
+  child->blocked_on = NULL;
+  list_init(&child->locks);
+  task_link(child, task);
+  task_place(child, 0);
+
+  task_copy_fs(child, task);
+
+  task_build_stack(child);
+
+  task_enqueue(child);
+
+  // ӽ˳ǰ̲Уƻûջ
+  while (child->vfork) {
+    task_block(task, NULL, TASK_BLOCKED);
+  }
+
+  return pid;
+}
+
+// ӽ̹黹ĵַռ䣬Ѹ
+static void task_vfork_release(task_t *task) {
+  assert(task->vfork);
+
+  task_t *parent = task_find(task->ppid);
+  assert(parent->pde == task->pde);
+  assert(parent->state == TASK_BLOCKED);
+
+  parent->brk = task->brk;
+  task->vfork = false;
+  task_unblock(parent);
+}
+
 void task_exit(int status) {
   task_t *task = running_task();
 
   assert(task->node.next == NULL && task->node.prev == NULL &&
          task->state == TASK_RUNNING);
 
+  // ߳̿ʹý̵ĵַռ
+  uring_exit(task);
+
   task->state = TASK_DIED;
   task->status = status;
 
-  // ͷҳĿ¼
-  free_pde();
-  // ͷλͼ
-  free_kpage((uint32)task->vmap->bits, 1);
-  kfree(task->vmap);
+  if (task->vfork) {
+    // ַռڸ
+    task_vfork_release(task);
+  } else {
+    // ͷҳĿ¼֮ں̲߳ٽ
+    free_pde();
+    set_cr3(KERNEL_PAGE_DIR);
+    // ͷλͼ
+    free_kpage((uint32)task->vmap->bits, 1);
+    kfree(task->vmap);
+  }
 
   free_kpage((uint32)task->pwd, 1);
   iput(task->ipwd);
   iput(task->iroot);
 
-  for (size_t i = 0; i < TASK_FILE_NR; ++i) {
-    file_t *file = task->files[i];
+  for (size_t i = 0; i < task->fdt.size; ++i) {
+    file_t *file = task->fdt.files[i];
     if (file) {
       close(i);
     }
   }
+  fd_table_free(&task->fdt);
 
   // ǰ̵ӽppidֵδǰ̵ppid
-  for (size_t i = 0; i < NR_TASKS; ++i) {
-    task_t *child = task_table[i];
-    if (!child) {
-      continue;
-    }
-    if (child->ppid != task->pid) {
-      continue;
-    }
+  task_t *parent = task_find(task->ppid);
+  if (parent == task) {
+    parent = NULL;
+  }
+  while (!list_empty(&task->children)) {
+    list_node_t *node = list_pop(&task->children);
+    task_t *child = element_entry(task_t, sibling, node);
     child->ppid = task->ppid;
+    if (parent) {
+      list_insert_after(&parent->children.head, node);
+    }
   }
 
   // ӽ˳֪ͨһ¸̣-1޲ӽ
-  task_t *parent = task_table[task->ppid];
-  if (parent->state == TASK_WAITING &&
+  if (parent && parent->state == TASK_WAITING &&
       (parent->waitpid == -1 || parent->waitpid == task->pid)) {
     task_unblock(parent);
   }
@@ -158,21 +501,17 @@ pid_t task_waitpid(pid_t pid, int *status) {
 
   while (1) {
     bool has_child = false;
-    for (size_t i = 2; i < NR_TASKS; ++i) {
-      task_t *ptr = task_table[i];
-      if (!ptr) {
-        continue;
-      }
-      if (ptr->ppid != task->pid) {
-        continue;
-      }
+    list_t *list = &task->children;
+    for (list_node_t *node = list->head.next; node != &list->tail;
+         node = node->next) {
+      task_t *ptr = element_entry(task_t, sibling, node);
       if (pid != ptr->pid && pid != -1) {
         continue;
       }
 
       if (ptr->state == TASK_DIED) {
         child = ptr;
-        task_table[i] = NULL;
+        task_unlink(child);
         goto rollback;
       }
       has_child = true;
@@ -199,50 +538,50 @@ pid_t sys_getpid() { return running_task()->pid; }
 
 pid_t sys_getppid() { return running_task()->ppid; }
 
-fd_t task_get_fd(task_t *task) {
-  fd_t i;
-  for (i = 3; i < TASK_FILE_NR; ++i) {
-    if (!task->files[i]) {
-      break;
+int sys_nice(int increment) {
+  task_t *task = running_task();
+  int nice = task->nice + increment;
+  nice = MAX(nice, NICE_MIN);
+  nice = MIN(nice, NICE_MAX);
+
+  task->nice = nice;
+  lock_reweight(task);
+  return nice;
+}
+
+fd_t task_get_fd(task_t *task, file_t *file) {
+  fd_table_t *fdt = &task->fdt;
+  fd_t fd = bitmap_alloc(&fdt->map, fdt->next);
+  if (fd == EOF) {
+    // ꣬ӱһ
+    fd = fdt->size;
+    if (!fd_table_grow(fdt)) {
+      return EOF;
     }
+    bitmap_set(&fdt->map, fd, true);
   }
-  if (i == TASK_FILE_NR) {
-    panic("Exceed task max open files");
-  }
-  return i;
+
+  fdt->files[fd] = file;
+  fdt->next = fd + 1;
+  return fd;
 }
 
 void task_put_fd(task_t *task, fd_t fd) {
   if (fd < 3) {
     return;
   }
-  assert(fd < TASK_FILE_NR);
-  task->files[fd] = NULL;
+  fd_table_t *fdt = &task->fdt;
+  assert(fd < fdt->size);
+  fdt->files[fd] = NULL;
+  bitmap_set(&fdt->map, fd, false);
+  fdt->next = MIN(fdt->next, fd);
 }
 
-static task_t *task_search(task_state_t state) {
-  assert(!get_interrupt_state()); // ж
-
-  task_t *task = NULL;
-  task_t *current = running_task();
-
-  for (size_t i = 0; i < NR_TASKS; ++i) {
-    task_t *ptr = task_table[i];
-    if (ptr == NULL || ptr->state != state || current == ptr) {
-      continue;
-    }
-
-    if (task == NULL || task->ticks < ptr->ticks ||
-        task->jiffies > ptr->jiffies) {
-      task = ptr;
-    }
+file_t *task_file(task_t *task, fd_t fd) {
+  if (fd < 0 || fd >= task->fdt.size) {
+    return NULL;
   }
-
-  if (task == NULL && state == TASK_READY) {
-    task = idle_task;
-  }
-
-  return task;
+  return task->fdt.files[fd];
 }
 
 task_t *running_task() {
@@ -253,12 +592,17 @@ task_t *running_task() {
 void task_activate(task_t *task) {
   assert(task->magic == CONIX_MAGIC);
 
-  if (task->pde != get_cr3()) {
+  // ں̲߳ûռ䣬ֱӽõǰĵַռ䣬ˢ TLB
+  // ദʱ CPU ͷŽõҳĿ¼ܽ
+  bool lazy = task->uid == KERNEL_USER && task->pde == KERNEL_PAGE_DIR &&
+              !smp_enabled;
+  if (!lazy && task->pde != get_active_pde()) {
     set_cr3(task->pde);
   }
   if (task->uid != KERNEL_USER) {
-    tss.esp0 = (uint32)task + PAGE_SIZE;
+    task->cpu->tss->esp0 = (uint32)task + PAGE_SIZE;
   }
+  vdso_update_pid(task->pid, task->ppid);
 }
 
 extern void task_switch(task_t *next);
@@ -266,20 +610,40 @@ void schedule() {
   assert(!get_interrupt_state()); // ж
 
   task_t *cur = running_task();
-  task_t *next = task_search(TASK_READY);
-  assert(next != NULL);
-  assert(next->magic == CONIX_MAGIC);
-
+  cpu_t *cpu = cur->cpu;
   if (cur->state == TASK_RUNNING) {
-    cur->state = TASK_READY;
+    task_enqueue(cur);
   }
 
+  uint32 start = sched_clock();
+  task_t *next = task_dequeue(cpu);
+  uint32 end = sched_clock();
+  assert(next != NULL);
+  assert(next->magic == CONIX_MAGIC);
+
   next->state = TASK_RUNNING;
+  next->cpu = cpu;
+  cpu->current = next;
   if (next == cur) {
     return;
   }
+
+  sched_stat.switches++;
+  sched_stat.pick = end - start;
+  sched_stat.pick_max = MAX(sched_stat.pick_max, sched_stat.pick);
+  sched_stat.latency = end - next->ready;
+  sched_stat.latency_max = MAX(sched_stat.latency_max, sched_stat.latency);
+
   task_activate(next);
+
+  // ں CPU һӵһ㿪ʼ
+  uint32 depth = cpu->lock_depth;
+  if (smp_enabled) {
+    cpu->lock_depth = 1;
+  }
   task_switch(next);
+  // Ѿ CPU 
+  cur->cpu->lock_depth = depth;
 }
 
 static task_t *task_create(target_t target, const char *name, uint32 priority,
@@ -302,7 +666,9 @@ static task_t *task_create(target_t target, const char *name, uint32 priority,
   task->priority = priority;
   task->ticks = task->priority;
   task->jiffies = 0;
-  task->state = TASK_READY;
+  task->nice = priority_nice(priority);
+  task->weight = task_base_weight(task);
+  list_init(&task->locks);
   task->uid = uid;
   task->gid = 0;
   task->vmap = &kernel_map;
@@ -315,9 +681,13 @@ static task_t *task_create(target_t target, const char *name, uint32 priority,
   strcpy(task->pwd, "/");
 
   task->umask = 0022;
+  fd_table_init(&task->fdt, TASK_FILE_NR);
 
   task->magic = CONIX_MAGIC;
 
+  task_link(task, task_find(task->ppid));
+  task_place(task, 0);
+
   return task;
 }
 
@@ -369,8 +739,38 @@ static void task_setup() {
   task_t *task = running_task();
   task->magic = CONIX_MAGIC;
   task->ticks = 1;
+  task->cpu = &cpus[0];
+  task->blocked_on = NULL;
+  list_init(&task->locks);
+  fd_table_init(&task->fdt, TASK_FILE_NR);
+  cpus[0].current = task;
+
+  bitmap_init(&pid_map, (char *)alloc_kpage(1), PID_MAX / 8, 0);
+  last_pid = -1;
+  for (size_t i = 0; i < PID_HASH_NR; ++i) {
+    list_init(&pid_hash[i]);
+  }
+}
+
+void task_tick() {
+  task_t *task = running_task();
+  assert(task->magic == CONIX_MAGIC);
+
+  task->jiffies = jiffies;
+  task->ticks--;
+  if (task->weight) {
+    task->vruntime += (NICE_0_WEIGHT << 10) / task->weight;
+  }
 
-  memset(task_table, 0, sizeof(task_table));
+  // ʱƬ꣬о̫
+  runqueue_t *rq = &task->cpu->rq;
+  bool preempt =
+      rq->size > 0 &&
+      vruntime_before(rq->heap[0]->vruntime + WAKEUP_GRAN, task->vruntime);
+  if (!task->ticks || preempt) {
+    task->ticks = task->priority;
+    schedule();
+  }
 }
 
 void task_yield() { schedule(); }
@@ -398,72 +798,64 @@ void task_unblock(task_t *task) {
 
   list_remove(&task->node);
 
-  assert(task->node.next == NULL);
-  assert(task->node.prev == NULL);
+  task_place(task, SLEEPER_CREDIT);
+  task_enqueue(task);
+}
 
-  task->state = TASK_READY;
+static void task_timeout(void *data) {
+  task_t *task = (task_t *)data;
+  assert(task->state == TASK_SLEEPING);
+
+  task_place(task, SLEEPER_CREDIT);
+  task_enqueue(task);
 }
 
 void task_sleep(uint32 ms) {
   assert(!get_interrupt_state());
-  uint32 ticks = ms / jiffy; // Ҫ˯ߵʱƬ
-  ticks = ticks > 0 ? ticks : 1;
 
-  // ʱ
   task_t *cur = running_task();
-  cur->ticks = jiffies + ticks;
-
-  list_t *list = &sleep_list;
-  list_node_t *anchor = &list->tail;
-
-  for (list_node_t *ptr = list->head.next; ptr != &list->tail;
-       ptr = ptr->next) {
-    task_t *task = element_entry(task_t, node, ptr);
-
-    if (task->ticks > cur->ticks) {
-      anchor = ptr;
-      break;
-    }
-  }
   assert(cur->node.next == NULL);
   assert(cur->node.prev == NULL);
-  list_insert_before(anchor, &cur->node);
+  timer_add(&cur->timer, ms, task_timeout, cur);
 
   cur->state = TASK_SLEEPING;
   schedule();
 }
 
-void task_wakeup() {
-  assert(!get_interrupt_state());
-
-  list_t *list = &sleep_list;
-  for (list_node_t *ptr = list->head.next; ptr != &list->tail;) {
-    task_t *task = element_entry(task_t, node, ptr);
-
-    if (task->ticks > jiffies) {
-      break;
-    }
-
-    // ҵʱƬСȫʱƬ񲢻
-    ptr = ptr->next;
-    task->ticks = 0;
-    task_unblock(task);
-  }
+bool task_idle() {
+  cpu_t *cpu = cpu_current();
+  return running_task() == cpu->idle && !cpu->rq.size;
 }
 
 extern void idle_thread();
 extern void init_thread();
 extern void test_thread();
+extern void uring_thread();
 
 void task_init() {
   list_init(&block_list);
-  list_init(&sleep_list);
+  tsc_support = cpu_has(CPU_FEATURE_TSC);
 
   task_setup();
 
-  // idle_task = task_create(idle_thread, "idle", 5, KERNEL_USER);
+  for (size_t i = 0; i < cpu_count; ++i) {
+    runqueue_init(&cpus[i].rq);
+  }
 
-  task_create(init_thread, "init", 5, NORMAL_USER);
-  task_create(test_thread, "test", 5, NORMAL_USER);
-  task_create(test_thread, "test", 5, NORMAL_USER);
+  // ÿ CPU һ񣬲Уûʱ
+  cpus[0].idle = task_create(idle_thread, "idle", 1, KERNEL_USER);
+  cpus[0].idle->state = TASK_READY;
+
+  task_enqueue(task_create(init_thread, "init", 5, NORMAL_USER));
+  task_enqueue(task_create(uring_thread, "uring", 5, KERNEL_USER));
+  task_enqueue(task_create(test_thread, "test", 5, NORMAL_USER));
+  task_enqueue(task_create(test_thread, "test", 5, NORMAL_USER));
+
+  // ӦôĿ smp_boot ֱӽ
+  for (size_t i = 1; i < cpu_count; ++i) {
+    cpu_t *cpu = &cpus[i];
+    cpu->idle = task_create(idle_thread, "idle", 1, KERNEL_USER);
+    cpu->idle->cpu = cpu;
+    cpu->idle->state = TASK_READY;
+  }
 }
@@ -1,29 +1,150 @@
 #include "../include/conix/arena.h"
+#include "../include/conix/cpu.h"
 #include "../include/conix/debug.h"
 #include "../include/conix/interrupt.h"
 #include "../include/conix/mutex.h"
 #include "../include/conix/printk.h"
+#include "../include/conix/smp.h"
 #include "../include/conix/stdio.h"
 #include "../include/conix/syscall.h"
+#include "../include/conix/task.h"
+#include "../include/conix/vdso.h"
 
 #define LOG_DEBUG(fmt, args...) DEBUGK(fmt, ##args)
 
+extern uint32 clock_now();
+extern void clock_reschedule(uint32 expires);
+
+idle_stat_t idle_stat;
+
 void idle_thread() {
   set_interrupt_state(true);
-  uint32 counter = 0;
 
   while (1) {
-    LOG_DEBUG("idle task... %d\n", counter++);
+    // sti һִָкӦжϣ hlt ǰж
+    asm volatile("cli\n");
+    cpu_t *cpu = cpu_current();
+    // ϴ yield ֮жϻֱӵȣͣ
+    if (!task_idle()) {
+      if (!cpu->id) {
+        clock_reschedule(clock_now());
+      }
+      asm volatile("sti\n");
+      yield();
+      continue;
+    }
+    uint32 start = clock_now();
+    idle_stat.halts++;
+    cpu->halted = true;
+    // ͣڼ CPU Խں
+    kernel_unlock();
     asm volatile("sti\n"
                  "hlt\n"); // ͣCPUͣ״̬ȴж
 
+    asm volatile("cli\n");
+    // ѵжϲͳƷΧʱ
+    cpu->halted = false;
+    kernel_lock();
+    uint32 end = clock_now();
+    idle_stat.idle += end - start;
+    // жϻ񣬻ָʱӣPIT ֻ
+    if (!task_idle() && !cpu->id) {
+      clock_reschedule(end);
+    }
+    asm volatile("sti\n");
+
     yield();
   }
 }
 
+#define BENCH_LOOPS 1000 // ÿϵͳòĴ
+#define FORK_LOOPS 100   // ӽ̲Ĵ
+
+typedef uint32 (*bench_call_t)(uint32 nr);
+
+static uint32 int80_syscall(uint32 nr) {
+  uint32 ret;
+  asm volatile("int $0x80\n" : "=a"(ret) : "a"(nr));
+  return ret;
+}
+
+//  vdso ڣ֧ sysenter ʱ˻ int 0x80
+static uint32 vdso_syscall(uint32 nr) {
+  uint32 ret;
+  asm volatile("call %P[entry]\n"
+               : "=a"(ret)
+               : "a"(nr), [entry] "i"(VDSO_SYSCALL));
+  return ret;
+}
+
+// ƽÿϵͳõʱ
+static uint32 bench_syscall(bench_call_t call, uint32 nr) {
+  uint32 start = (uint32)rdtsc();
+  for (size_t i = 0; i < BENCH_LOOPS; ++i) {
+    call(nr);
+  }
+  return ((uint32)rdtsc() - start) / BENCH_LOOPS;
+}
+
+// Ƚ int 0x80vdso ں vdso ҳַʽĿ
+static void bench_syscalls() {
+  uint32 start = (uint32)rdtsc();
+  for (size_t i = 0; i < BENCH_LOOPS; ++i) {
+    getpid();
+  }
+  uint32 page = ((uint32)rdtsc() - start) / BENCH_LOOPS;
+  printf("getpid: int80 %d sysenter %d vdso %d cycles\n",
+         bench_syscall(int80_syscall, SYS_NR_GETPID),
+         bench_syscall(vdso_syscall, SYS_NR_GETPID), page);
+
+  start = (uint32)rdtsc();
+  for (size_t i = 0; i < BENCH_LOOPS; ++i) {
+    time();
+  }
+  page = ((uint32)rdtsc() - start) / BENCH_LOOPS;
+  printf("time: int80 %d sysenter %d vdso %d cycles\n",
+         bench_syscall(int80_syscall, SYS_NR_TIME),
+         bench_syscall(vdso_syscall, SYS_NR_TIME), page);
+
+  printf("yield: int80 %d sysenter %d cycles\n",
+         bench_syscall(int80_syscall, SYS_NR_YIELD),
+         bench_syscall(vdso_syscall, SYS_NR_YIELD));
+}
+
+// Ƚ vfork  fork ӽ̡ӽ˳յƽ
+static void bench_fork() {
+  int32 status;
+  uint32 start = (uint32)rdtsc();
+  for (size_t i = 0; i < FORK_LOOPS; ++i) {
+    pid_t pid = vfork();
+    if (!pid) {
+      exit(0);
+    }
+    waitpid(pid, &status);
+  }
+  uint32 vfork_cycles = ((uint32)rdtsc() - start) / FORK_LOOPS;
+
+  start = (uint32)rdtsc();
+  for (size_t i = 0; i < FORK_LOOPS; ++i) {
+    pid_t pid = fork();
+    if (!pid) {
+      exit(0);
+    }
+    waitpid(pid, &status);
+  }
+  uint32 fork_cycles = ((uint32)rdtsc() - start) / FORK_LOOPS;
+
+  printf("vfork+waitpid %d fork+waitpid %d cycles\n", vfork_cycles,
+         fork_cycles);
+}
+
+// û̬еĲԣ init_thread е task_to_user_mode 
 static void user_init_thread() {
   uint32 count = 0;
 
+  bench_syscalls();
+  bench_fork();
+
   char ch;
   while (1) {
     // printf("init thread %d %d %d\n", getpid(), getppid(), count++);
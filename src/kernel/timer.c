@@ -0,0 +1,122 @@
+#include "../include/conix/timer.h"
+#include "../include/conix/assert.h"
+#include "../include/conix/interrupt.h"
+
+// ּʱ֣һÿ 1 룬֮ÿĲһһȦʱ
+#define TVR_BITS 8
+#define TVN_BITS 6
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TVN_NR 3
+
+// ʱܱʾʱ䣬Լ 18 Сʱ
+#define MAX_TVAL ((1 << (TVR_BITS + TVN_NR * TVN_BITS)) - 1)
+
+#define TVN_INDEX(expires, n)                                                  \
+  (((expires) >> (TVR_BITS + (n) * TVN_BITS)) & TVN_MASK)
+
+extern uint32 clock_now();
+extern void clock_reschedule(uint32 expires);
+
+static list_t tv1[TVR_SIZE];
+static list_t tvn[TVN_NR][TVN_SIZE];
+static uint32 timer_ms; // һҪʱ
+
+static void timer_insert(timer_t *timer) {
+  uint32 idx = timer->expires - timer_ms;
+  list_t *list;
+
+  if (time_before(timer->expires, timer_ms)) {
+    // Ѿڣһδ
+    list = &tv1[timer_ms & TVR_MASK];
+  } else if (idx < TVR_SIZE) {
+    list = &tv1[timer->expires & TVR_MASK];
+  } else {
+    if (idx > MAX_TVAL) {
+      idx = MAX_TVAL;
+      timer->expires = timer_ms + idx;
+    }
+    uint32 n = 0;
+    while (idx >= (1 << (TVR_BITS + (n + 1) * TVN_BITS))) {
+      n++;
+    }
+    list = &tvn[n][TVN_INDEX(timer->expires, n)];
+  }
+
+  list_insert_before(&list->tail, &timer->node);
+}
+
+// ѵ n ǰ۵ĶʱŻصһز۵
+static uint32 cascade(uint32 n) {
+  uint32 index = TVN_INDEX(timer_ms, n);
+  list_t *list = &tvn[n][index];
+  while (!list_empty(list)) {
+    timer_t *timer = element_entry(timer_t, node, list_pop(list));
+    timer_insert(timer);
+  }
+  return index;
+}
+
+void timer_add(timer_t *timer, uint32 ms, timer_handler_t handler, void *data) {
+  assert(!get_interrupt_state()); // ж
+  assert(timer->node.next == NULL && timer->node.prev == NULL);
+
+  // ǰѾȥһ֣һ뱣֤ǰ
+  timer->expires = clock_now() + ms + 1;
+  timer->handler = handler;
+  timer->data = data;
+  timer_insert(timer);
+
+  clock_reschedule(timer->expires);
+}
+
+void timer_del(timer_t *timer) {
+  assert(!get_interrupt_state()); // ж
+  if (timer->node.next) {
+    list_remove(&timer->node);
+  }
+}
+
+void timer_expire(uint32 now) {
+  assert(!get_interrupt_state()); // ж
+
+  while (!time_before(now, timer_ms)) {
+    uint32 index = timer_ms & TVR_MASK;
+    // һתһȦӸһȡĶʱ
+    if (!index) {
+      for (uint32 n = 0; n < TVN_NR && !cascade(n); ++n)
+        ;
+    }
+    timer_ms++;
+
+    list_t *list = &tv1[index];
+    while (!list_empty(list)) {
+      timer_t *timer = element_entry(timer_t, node, list_pop(list));
+      timer->handler(timer->data);
+    }
+  }
+}
+
+uint32 timer_next(uint32 now, uint32 max) {
+  for (uint32 ms = timer_ms; time_before(ms, now + max); ++ms) {
+    // ҪչһĶʱ
+    if (!(ms & TVR_MASK) || !list_empty(&tv1[ms & TVR_MASK])) {
+      return time_before(ms, now) ? 0 : ms - now;
+    }
+  }
+  return max;
+}
+
+void timer_init() {
+  for (size_t i = 0; i < TVR_SIZE; ++i) {
+    list_init(&tv1[i]);
+  }
+  for (size_t n = 0; n < TVN_NR; ++n) {
+    for (size_t i = 0; i < TVN_SIZE; ++i) {
+      list_init(&tvn[n][i]);
+    }
+  }
+  timer_ms = 0;
+}
@@ -0,0 +1,77 @@
+[bits 16]
+
+; Ӧô룬Ƶ AP_BOOT  STARTUP ʵģʽʼִ
+
+AP_BOOT equ 0x8000
+
+code_selector equ (1 << 3)
+data_selector equ (2 << 3)
+
+; ַ֮
+%define REL(x) (AP_BOOT + (x) - ap_trampoline_start)
+
+section .text
+
+global ap_trampoline_start
+ap_trampoline_start:
+    cli ; ж
+
+    xor ax, ax
+    mov ds, ax
+
+    ; ʹ gdt
+    o32 lgdt [REL(ap_gdt_ptr)]
+
+    ; ģʽ
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+
+    ; תˢ»棬뱣ģʽ
+    jmp dword code_selector:REL(ap_protect_mode)
+
+[bits 32]
+ap_protect_mode:
+    mov ax, data_selector
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; ںʹ 4M ҳ cr4 ٿҳ
+    mov eax, [REL(ap_cr4)]
+    mov cr4, eax
+    mov eax, [REL(ap_cr3)]
+    mov cr3, eax
+
+    mov eax, cr0
+    or eax, 0x80000000
+    mov cr0, eax
+
+    mov esp, [REL(ap_stack)]; ջ
+    mov eax, [REL(ap_entry)]
+    call eax
+
+    ; ᷵
+    ud2
+
+; ²ڸƺд
+align 4
+global ap_gdt_ptr
+ap_gdt_ptr:
+    dw 0
+    dd 0
+
+align 4
+global ap_cr3
+ap_cr3: dd 0
+global ap_cr4
+ap_cr4: dd 0
+global ap_stack
+ap_stack: dd 0
+global ap_entry
+ap_entry: dd 0
+
+global ap_trampoline_end
+ap_trampoline_end:
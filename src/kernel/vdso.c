@@ -0,0 +1,142 @@
+#include "../include/conix/vdso.h"
+#include "../include/conix/cpu.h"
+#include "../include/conix/debug.h"
+#include "../include/conix/global.h"
+#include "../include/conix/smp.h"
+#include "../include/conix/string.h"
+#include "../include/conix/task.h"
+
+#define LOG_DEBUG(fmt, args...) DEBUGK(fmt, ##args)
+
+bool sysenter_enabled = false;
+
+// ͨں˵ĺӳдҳ
+static vdso_data_t volatile *vdso_data = NULL;
+
+extern uint32 volatile jiffies;
+extern uint32 jiffy;
+extern time_t startup_time;
+
+// sysexit û̬ĵַ sysenter_handler дж֡
+uint32 sysenter_return;
+
+extern void sysenter_handler();
+
+// ڴ븴Ƶ VDSO_ADDR ִУֻʹת
+
+// ֧ sysenter ʱֱʹж
+extern char vdso_int80_start[];
+extern char vdso_int80_end[];
+asm(".text\n"
+    "vdso_int80_start:\n"
+    "int $0x80\n"
+    "ret\n"
+    "vdso_int80_end:\n");
+
+// sysenter 淵صַûջûջָ ebp У
+// ں˷ص vdso_sysenter_returnָ sysexit ǵ ecx edx
+// ں߳Ҳ sysexit ֻܻصû̬Ȼʹж
+extern char vdso_sysenter_start[];
+extern char vdso_sysenter_return[];
+extern char vdso_sysenter_end[];
+asm(".text\n"
+    "vdso_sysenter_start:\n"
+    "pushl %ecx\n"
+    "movl %cs, %ecx\n"
+    "testl $3, %ecx\n"
+    "popl %ecx\n"
+    "jz 1f\n"
+    "pushl %ecx\n"
+    "pushl %edx\n"
+    "pushl %ebp\n"
+    "movl %esp, %ebp\n"
+    "sysenter\n"
+    "vdso_sysenter_return:\n"
+    "popl %ebp\n"
+    "popl %edx\n"
+    "popl %ecx\n"
+    "ret\n"
+    "1:\n"
+    "int $0x80\n"
+    "ret\n"
+    "vdso_sysenter_end:\n");
+
+static bool sysenter_support() {
+  if (!cpu_has(CPU_FEATURE_SEP)) {
+    return false;
+  }
+
+  // ڵ Pentium Pro ر֧ sysenter
+  uint32 eax, ebx, ecx, edx;
+  cpuid(1, &eax, &ebx, &ecx, &edx);
+  uint32 family = (eax >> 8) & 0xf;
+  uint32 model = (eax >> 4) & 0xf;
+  uint32 stepping = eax & 0xf;
+  return !(family == 6 && model < 3 && stepping < 3);
+}
+
+void sysenter_init() {
+  if (!sysenter_enabled) {
+    return;
+  }
+
+  tss_t *tss = cpu_current()->tss;
+  wrmsr(MSR_SYSENTER_CS, KERNEL_CODE_SELECTOR);
+  // ջָ tss е esp0ں˺ȡǰںջ
+  wrmsr(MSR_SYSENTER_ESP, (uint32)&tss->esp0);
+  wrmsr(MSR_SYSENTER_EIP, (uint32)sysenter_handler);
+}
+
+// дɴں
+static void vdso_write_begin() { vdso_data->seq++; }
+
+static void vdso_write_end() { vdso_data->seq++; }
+
+void vdso_update_time() {
+  if (!vdso_data) {
+    return;
+  }
+  vdso_write_begin();
+  vdso_data->jiffies = jiffies;
+  vdso_write_end();
+}
+
+void vdso_update_pid(pid_t pid, pid_t ppid) {
+  if (!vdso_data) {
+    return;
+  }
+  vdso_write_begin();
+  vdso_data->pid_valid = !smp_enabled;
+  vdso_data->pid = pid;
+  vdso_data->ppid = ppid;
+  vdso_write_end();
+}
+
+void vdso_init() {
+  uint32 page = alloc_kpage(1);
+  memset((void *)page, 0, PAGE_SIZE);
+
+  sysenter_enabled = sysenter_support();
+  if (sysenter_enabled) {
+    memcpy((void *)page, vdso_sysenter_start,
+           vdso_sysenter_end - vdso_sysenter_start);
+    sysenter_return =
+        VDSO_ADDR + (vdso_sysenter_return - vdso_sysenter_start);
+    sysenter_init();
+  } else {
+    memcpy((void *)page, vdso_int80_start, vdso_int80_end - vdso_int80_start);
+  }
+
+  link_shared(VDSO_ADDR, page);
+
+  page = alloc_kpage(1);
+  memset((void *)page, 0, PAGE_SIZE);
+  vdso_data = (vdso_data_t *)page;
+  vdso_data->jiffies = jiffies;
+  vdso_data->jiffy = jiffy;
+  vdso_data->startup_time = startup_time;
+  vdso_update_pid(running_task()->pid, running_task()->ppid);
+
+  link_shared(VDSO_DATA_ADDR, page);
+  LOG_DEBUG("vdso at 0x%p sysenter %d\n", VDSO_ADDR, sysenter_enabled);
+}
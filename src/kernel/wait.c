@@ -0,0 +1,52 @@
+#include "../include/conix/wait.h"
+#include "../include/conix/assert.h"
+#include "../include/conix/interrupt.h"
+#include "../include/conix/task.h"
+
+void wait_queue_init(wait_queue_t *wq) {
+  list_init(&wq->shared);
+  list_init(&wq->exclusive);
+}
+
+void wait_sleep(wait_queue_t *wq, bool exclusive) {
+  assert(!get_interrupt_state()); // ж
+
+  // task_block 뵽ͷĵȴβ
+  list_t *list = exclusive ? &wq->exclusive : &wq->shared;
+  task_block(running_task(), list, TASK_BLOCKED);
+}
+
+static task_t *wait_wakeup_one(list_t *list) {
+  task_t *task = element_entry(task_t, node, list->tail.prev);
+  assert(task->state == TASK_BLOCKED);
+  task_unblock(task);
+  return task;
+}
+
+uint32 wait_wakeup(wait_queue_t *wq, uint32 nr) {
+  assert(!get_interrupt_state()); // ж
+
+  uint32 count = 0;
+  while (!list_empty(&wq->shared)) {
+    wait_wakeup_one(&wq->shared);
+    count++;
+  }
+  for (; nr && !list_empty(&wq->exclusive); --nr) {
+    wait_wakeup_one(&wq->exclusive);
+    count++;
+  }
+  return count;
+}
+
+task_t *wait_handoff(wait_queue_t *wq) {
+  assert(!get_interrupt_state()); // ж
+
+  if (list_empty(&wq->exclusive)) {
+    return NULL;
+  }
+  return wait_wakeup_one(&wq->exclusive);
+}
+
+bool wait_active(wait_queue_t *wq) {
+  return !list_empty(&wq->shared) || !list_empty(&wq->exclusive);
+}
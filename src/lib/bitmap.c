@@ -82,3 +82,25 @@ int bitmap_scan(bitmap_t *map, uint32 count) {
   }
   return map->offset + start;
 }
+
+int bitmap_alloc(bitmap_t *map, idx_t index) {
+  assert(index >= map->offset);
+
+  idx_t idx = index - map->offset;
+  for (uint32 bytes = idx / 8; bytes < map->length; ++bytes) {
+    // ֽ
+    uint8 byte = map->bits[bytes] & 0xff;
+    if (byte == (uint8)0xff) {
+      continue;
+    }
+
+    uint8 bits = bytes == idx / 8 ? idx % 8 : 0;
+    for (; bits < 8; ++bits) {
+      if (!(byte & (1 << bits))) {
+        map->bits[bytes] |= (1 << bits);
+        return map->offset + bytes * 8 + bits;
+      }
+    }
+  }
+  return EOF;
+}
@@ -1,27 +1,46 @@
 #include "../include/conix/syscall.h"
+#include "../include/conix/vdso.h"
 
+//  vdso еڽںˣںѡ sysenter  int 0x80
 static uint32 _syscall0(uint32 nr) {
   uint32 ret;
-  asm volatile("int $0x80\n" : "=a"(ret) : "a"(nr));
+  asm volatile("call %P[entry]\n"
+               : "=a"(ret)
+               : "a"(nr), [entry] "i"(VDSO_SYSCALL));
   return ret;
 }
 
 static uint32 _syscall1(uint32 nr, uint32 arg) {
   uint32 ret;
-  asm volatile("int $0x80\n" : "=a"(ret) : "a"(nr), "b"(arg));
+  asm volatile("call %P[entry]\n"
+               : "=a"(ret)
+               : "a"(nr), "b"(arg), [entry] "i"(VDSO_SYSCALL));
   return ret;
 }
 
 static uint32 _syscall2(uint32 nr, uint32 arg1, uint32 arg2) {
   uint32 ret;
-  asm volatile("int $0x80\n" : "=a"(ret) : "a"(nr), "b"(arg1), "c"(arg2));
+  asm volatile("call %P[entry]\n"
+               : "=a"(ret)
+               : "a"(nr), "b"(arg1), "c"(arg2), [entry] "i"(VDSO_SYSCALL));
   return ret;
 }
 static uint32 _syscall3(uint32 nr, uint32 arg1, uint32 arg2, uint32 arg3) {
   uint32 ret;
-  asm volatile("int $0x80\n"
+  asm volatile("call %P[entry]\n"
+               : "=a"(ret)
+               : "a"(nr), "b"(arg1), "c"(arg2), "d"(arg3),
+                 [entry] "i"(VDSO_SYSCALL));
+  return ret;
+}
+
+static uint32 _syscall4(uint32 nr, uint32 arg1, uint32 arg2, uint32 arg3,
+                        uint32 arg4) {
+  uint32 ret;
+  asm volatile("call %P[entry]\n"
                : "=a"(ret)
-               : "a"(nr), "b"(arg1), "c"(arg2), "d"(arg3));
+               : "a"(nr), "b"(arg1), "c"(arg2), "d"(arg3), "S"(arg4),
+                 [entry] "i"(VDSO_SYSCALL));
   return ret;
 }
 
@@ -35,17 +54,76 @@ void exit(int status) { _syscall1(SYS_NR_EXIT, (uint32)status); }
 
 pid_t fork() { return _syscall0(SYS_NR_FORK); }
 
-pid_t getpid() { return _syscall0(SYS_NR_GETPID); }
+// ӽڸ̵ûջϣصַȱ浽Ĵ
+// ӽ̵ĵûḲǸ vfork ջ֡
+// sysenter ҲҪûջϱĴֻʹ int 0x80
+asm(".text\n"
+    ".globl vfork\n"
+    "vfork:\n"
+    "popl %ecx\n"
+    "movl $190, %eax\n" // SYS_NR_VFORK
+    "int $0x80\n"
+    "jmp *%ecx\n");
+
+//  vdso ҳȡں
+pid_t getpid() {
+  vdso_data_t volatile *data = (vdso_data_t *)VDSO_DATA_ADDR;
+  uint32 seq;
+  pid_t pid;
+  do {
+    seq = data->seq;
+    if (!data->pid_valid) {
+      return _syscall0(SYS_NR_GETPID);
+    }
+    pid = data->pid;
+  } while ((seq & 1) || seq != data->seq);
+  return pid;
+}
 
-pid_t getppid() { return _syscall0(SYS_NR_GETPPID); }
+pid_t getppid() {
+  vdso_data_t volatile *data = (vdso_data_t *)VDSO_DATA_ADDR;
+  uint32 seq;
+  pid_t ppid;
+  do {
+    seq = data->seq;
+    if (!data->pid_valid) {
+      return _syscall0(SYS_NR_GETPPID);
+    }
+    ppid = data->ppid;
+  } while ((seq & 1) || seq != data->seq);
+  return ppid;
+}
 
 pid_t waitpid(pid_t pid, int32 *status) {
   return _syscall2(SYS_NR_WAITPID, pid, (uint32)status);
 }
 
+int nice(int increment) { return _syscall1(SYS_NR_NICE, (uint32)increment); }
+
 int32 brk(void *addr) { return _syscall1(SYS_NR_BRK, (uint32)addr); }
 
-time_t time() { return _syscall0(SYS_NR_TIME); }
+void *sbrk(int32 increment) {
+  uint32 addr = brk(NULL);
+  if (increment && brk((void *)(addr + increment)) == EOF) {
+    return (void *)EOF;
+  }
+  return (void *)addr;
+}
+
+time_t time() {
+  vdso_data_t volatile *data = (vdso_data_t *)VDSO_DATA_ADDR;
+  uint32 seq;
+  time_t now;
+  do {
+    seq = data->seq;
+    now = data->startup_time + (data->jiffies * data->jiffy) / 1000;
+  } while ((seq & 1) || seq != data->seq);
+  return now;
+}
+
+int kstat(kstat_type_t type, void *buf) {
+  return _syscall2(SYS_NR_KSTAT, (uint32)type, (uint32)buf);
+}
 
 fd_t open(char *filename, int flags, int mode) {
   return _syscall3(SYS_NR_OPEN, (uint32)filename, (uint32)flags, (uint32)mode);
@@ -69,6 +147,34 @@ int lseek(fd_t fd, off_t offset, int whence) {
   return _syscall3(SYS_NR_LSEEK, fd, offset, whence);
 }
 
+int32 readv(fd_t fd, iovec_t *iov, int count) {
+  return _syscall3(SYS_NR_READV, fd, (uint32)iov, count);
+}
+
+int32 writev(fd_t fd, iovec_t *iov, int count) {
+  return _syscall3(SYS_NR_WRITEV, fd, (uint32)iov, count);
+}
+
+int32 pread(fd_t fd, char *buf, int len, off_t offset) {
+  return _syscall4(SYS_NR_PREAD, fd, (uint32)buf, len, offset);
+}
+
+int32 pwrite(fd_t fd, char *buf, int len, off_t offset) {
+  return _syscall4(SYS_NR_PWRITE, fd, (uint32)buf, len, offset);
+}
+
+int32 sendfile(fd_t out, fd_t in, off_t *offset, int count) {
+  return _syscall4(SYS_NR_SENDFILE, out, in, (uint32)offset, count);
+}
+
+int uring_setup(uring_t *ring) {
+  return _syscall1(SYS_NR_URING_SETUP, (uint32)ring);
+}
+
+int uring_enter(uint32 min_complete) {
+  return _syscall1(SYS_NR_URING_ENTER, min_complete);
+}
+
 int mkdir(char *pathname, int mode) {
   return _syscall2(SYS_NR_MKDIR, (uint32)pathname, mode);
 }